@@ -9,35 +9,75 @@ $submitButton.on('click', function(){
 
 var $batteryDisplayCheckbox = $('#batteryDisplayCheckbox');
 var $timeFormatCheckbox = $('#timeFormatCheckbox');
+var $invertColorCheckbox = $('#invertColorCheckbox');
 var $temperatureTab = $('.temp-tab');
+var $weatherIntervalSelect = $('#weatherIntervalSelect');
+var $powerSaverSelect = $('#powerSaverSelect');
+var $powerCriticalSelect = $('#powerCriticalSelect');
+var $useLocationCheckbox = $('#useLocationCheckbox');
+var $locationInput = $('#locationInput');
+var $birthdayListInput = $('#birthdayListInput');
 
 console.log('Loaded: ' + JSON.stringify(localStorage));
 
 if(localStorage.twentyFourHourFormat){
 	$batteryDisplayCheckbox[0].checked = localStorage.batteryDisplayOnOff === 'true';
 	$timeFormatCheckbox[0].checked = localStorage.twentyFourHourFormat === 'true';
+	$invertColorCheckbox[0].checked = localStorage.invertColor === 'true';
+	if(localStorage.weatherInterval)
+		$weatherIntervalSelect[0].value = localStorage.weatherInterval;
+	if(localStorage.powerSaver)
+		$powerSaverSelect[0].value = localStorage.powerSaver;
+	if(localStorage.powerCritical)
+		$powerCriticalSelect[0].value = localStorage.powerCritical;
 	for(var i = 0; i < $temperatureTab.length; i++){
 		$($temperatureTab[i]).removeClass("active");
 		if($($temperatureTab[i]).html() === localStorage.temperatureFormat){
 			$($temperatureTab[i]).addClass("active");
 		}
 	}
+	if(localStorage.useLocation)
+		$useLocationCheckbox[0].checked = localStorage.useLocation === 'true';
+	$locationInput[0].value = localStorage.location || '';
+	$birthdayListInput[0].value = localStorage.birthdayList || '';
 }
 
+/** Every setting the face has, so the phone never gets undefined ones **/
 function getAndStoreConfigData() {
 	var $batteryDisplayCheckbox = $('#batteryDisplayCheckbox');
 	var $timeFormatCheckbox = $('#timeFormatCheckbox');
+	var $invertColorCheckbox = $('#invertColorCheckbox');
 	var $temperatureTab = $('.temp-tab.active');
+	var $weatherIntervalSelect = $('#weatherIntervalSelect');
+	var $powerSaverSelect = $('#powerSaverSelect');
+	var $powerCriticalSelect = $('#powerCriticalSelect');
+	var $useLocationCheckbox = $('#useLocationCheckbox');
+	var $locationInput = $('#locationInput');
+	var $birthdayListInput = $('#birthdayListInput');
 
 	var options = {
 		twentyFourHourFormat: $timeFormatCheckbox[0].checked,
 		batteryDisplayOnOff: $batteryDisplayCheckbox[0].checked,
-		temperatureFormat: $temperatureTab.html()
+		temperatureFormat: $temperatureTab.html(),
+		invertColor: $invertColorCheckbox[0].checked,
+		weatherInterval: $weatherIntervalSelect[0].value,
+		powerSaver: $powerSaverSelect[0].value,
+		powerCritical: $powerCriticalSelect[0].value,
+		useLocation: $useLocationCheckbox[0].checked,
+		location: $locationInput[0].value.trim(),
+		birthdayList: $birthdayListInput[0].value.trim()
 	};
 
 	localStorage.twentyFourHourFormat = options.twentyFourHourFormat;
 	localStorage.batteryDisplayOnOff = options.batteryDisplayOnOff;
 	localStorage.temperatureFormat = options.temperatureFormat;
+	localStorage.invertColor = options.invertColor;
+	localStorage.weatherInterval = options.weatherInterval;
+	localStorage.powerSaver = options.powerSaver;
+	localStorage.powerCritical = options.powerCritical;
+	localStorage.useLocation = options.useLocation;
+	localStorage.location = options.location;
+	localStorage.birthdayList = options.birthdayList;
 
 	console.log("Got options: " + JSON.stringify(options));
 	return options;
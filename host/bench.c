@@ -0,0 +1,95 @@
+#include "host.h"
+
+/*
+ * Runs the face for a year of minutes on the simulated clock and reports
+ * what each tick cost: host time, Pebble calls, heap and persist traffic.
+ * The harness plays the phone, every weather request gets a reply.
+ *
+ * HOST_MINUTES   minutes to run, a year by default
+ * HOST_BATTERY   charge the watch reports, 80 by default
+ * HOST_START     unix time the clock starts at, 2025-01-01 by default
+ */
+
+// appKeys from appinfo.json, stable since the first release
+#define KEY_TEMPERATURE 0
+
+#define BENCH_MINUTES (365 * 24 * 60)
+#define BENCH_CELSIUS 20
+
+static uint64_t s_started;
+static uint64_t s_init_ns;
+static HostCounters s_init;
+static uint32_t s_minutes;
+static uint64_t s_run_ns;
+static uint64_t s_slowest_ns;
+static uint32_t s_replies;
+static HostCounters s_run;
+
+__attribute__((constructor)) static void bench_start(void){
+    s_started = host_now_ns();
+}
+
+static uint32_t env_number(const char *name, uint32_t fallback){
+    const char *value = getenv(name);
+    return value != NULL && *value != '\0' ? (uint32_t)strtoul(value, NULL, 10) : fallback;
+}
+
+/** Answer weather requests with a temperature, the face takes it as observed now **/
+static void answer_phone(void){
+    DictionaryIterator sent;
+    while(host_outbox_pop(&sent)){
+        if(dict_find(&sent, KEY_TEMPERATURE) == NULL)
+            continue;
+        DictionaryIterator *reply = host_inbox_begin();
+        dict_write_int32(reply, KEY_TEMPERATURE, BENCH_CELSIUS);
+        host_inbox_deliver();
+        s_replies++;
+    }
+}
+
+static void report(void){
+    uint32_t minutes = s_minutes > 0 ? s_minutes : 1;
+
+    printf("init        %8.3f ms, %u persist reads, %u allocs, heap %u bytes\n",
+        s_init_ns / 1e6, s_init.persist_reads, s_init.allocs, (unsigned)s_init.heap_peak);
+    printf("minutes     %8u, %u ticks, %u draws\n", s_minutes, s_run.ticks, s_run.draws);
+    printf("per minute  %8.0f ns mean, %.0f ns slowest\n", (double)s_run_ns / minutes, (double)s_slowest_ns);
+    printf("heap        %8u allocs, %u frees, peak %u bytes\n",
+        s_run.allocs, s_run.frees, (unsigned)s_run.heap_peak);
+    printf("persist     %8u writes, %u bytes, %u failed, %u bytes stored\n",
+        s_run.persist_writes, s_run.persist_write_bytes, s_run.persist_failures, (unsigned)host_persist_used());
+    printf("messages    %8u sent, %u received, %u weather replies\n",
+        s_run.outbox_sends, s_run.inbox_messages, s_replies);
+    printf("calls per minute:\n");
+    host_report_calls(stdout, minutes);
+}
+
+static void report_deinit(void){
+    HostCounters after;
+    host_get_counters(&after);
+    printf("deinit      %8u frees\n", after.frees - s_run.frees);
+}
+
+void host_run(void){
+    s_init_ns = host_now_ns() - s_started;
+    host_get_counters(&s_init);
+    host_reset_counters();
+
+    uint32_t minutes = env_number("HOST_MINUTES", BENCH_MINUTES);
+    host_set_battery((uint8_t)env_number("HOST_BATTERY", 80), false);
+
+    uint64_t start = host_now_ns();
+    for(s_minutes = 0; s_minutes < minutes; s_minutes++){
+        uint64_t before = host_now_ns();
+        host_advance(SECONDS_PER_MINUTE);
+        answer_phone();
+        host_idle();
+        uint64_t spent = host_now_ns() - before;
+        if(spent > s_slowest_ns)
+            s_slowest_ns = spent;
+    }
+    s_run_ns = host_now_ns() - start;
+    host_get_counters(&s_run);
+    report();
+    atexit(report_deinit);
+}
@@ -0,0 +1,199 @@
+#include "host.h"
+#include "text.h"
+
+/*
+ * Throws random text at the text arena through TEXT_FORMAT,
+ * text_format_string() and text_strftime(), the way the face fills its slots: names of any length
+ * in valid and broken UTF-8, inside the formats the banners, countdowns,
+ * dates and temperatures use. After every write the slot has to hold a
+ * terminated prefix of what was asked for, whole characters only when the
+ * input was valid UTF-8, and every other slot has to be untouched.
+ *
+ * Deterministic for a seed, so a failure can be replayed:
+ *
+ *   HOST_FUZZ_RUNS   writes to try, 200000 by default
+ *   HOST_FUZZ_SEED   seed of the generator, 1 by default
+ *
+ * make fuzz builds it with AddressSanitizer and UBSan as well.
+ */
+
+#define FUZZ_RUNS 200000
+// Longer than any slot, so every write gets cut somewhere
+#define FUZZ_TEXT_MAX 160
+
+static uint32_t s_state;
+static int s_failures;
+
+static uint32_t next_random(void){
+    // xorshift32
+    s_state ^= s_state << 13;
+    s_state ^= s_state >> 17;
+    s_state ^= s_state << 5;
+    return s_state;
+}
+
+static uint32_t below(uint32_t limit){
+    return next_random() % limit;
+}
+
+/** Append one character, length in bytes 1-4, or a stray byte when broken **/
+static size_t random_character(char *out, bool broken){
+    static const uint8_t strays[] = { 0x80, 0xBF, 0xC0, 0xE2, 0xF0, 0xFF };
+    if(broken){
+        out[0] = (char)strays[below(sizeof(strays))];
+        return 1;
+    }
+    switch(below(4)){
+        case 0:
+            out[0] = (char)(' ' + below(95));
+            return 1;
+        case 1:
+            // é and friends
+            out[0] = (char)(0xC3 + below(2));
+            out[1] = (char)(0x80 + below(64));
+            return 2;
+        case 2:
+            // ° and the CJK range
+            out[0] = (char)(0xE4 + below(5));
+            out[1] = (char)(0x80 + below(64));
+            out[2] = (char)(0x80 + below(64));
+            return 3;
+        default:
+            // Emoji
+            out[0] = (char)0xF0;
+            out[1] = (char)0x9F;
+            out[2] = (char)(0x98 + below(8));
+            out[3] = (char)(0x80 + below(64));
+            return 4;
+    }
+}
+
+/** A name of up to FUZZ_TEXT_MAX bytes, broken now and then **/
+static void random_name(char *name, bool *valid){
+    size_t length = 0;
+    size_t target = below(4) == 0 ? FUZZ_TEXT_MAX - 4 : below(FUZZ_TEXT_MAX - 4);
+    *valid = below(8) != 0;
+    while(length < target)
+        length += random_character(name + length, !*valid && below(4) == 0);
+    name[length] = '\0';
+}
+
+static bool valid_utf8(const char *text){
+    const uint8_t *bytes = (const uint8_t *)text;
+    while(*bytes != '\0'){
+        size_t length = *bytes < 0x80 ? 1 : (*bytes & 0xE0) == 0xC0 ? 2 : (*bytes & 0xF0) == 0xE0 ? 3 :
+                        (*bytes & 0xF8) == 0xF0 ? 4 : 0;
+        if(length == 0)
+            return false;
+        for(size_t i = 1; i < length; i++){
+            if((bytes[i] & 0xC0) != 0x80)
+                return false;
+        }
+        bytes += length;
+    }
+    return true;
+}
+
+static void fail(uint32_t run, TextSlot slot, const char *what){
+    fprintf(stderr, "fuzz_text: run %u, slot %d: %s\n", run, slot, what);
+    s_failures++;
+}
+
+/** Fill every slot but one with a marker to check it is left alone **/
+static void mark_others(TextSlot slot){
+    for(TextSlot other = 0; other < TEXT_SLOT_COUNT; other++){
+        if(other != slot)
+            memset(text_buffer(other), 'a' + other, text_size(other));
+    }
+}
+
+static bool others_intact(TextSlot slot){
+    for(TextSlot other = 0; other < TEXT_SLOT_COUNT; other++){
+        const char *buffer = text_buffer(other);
+        for(size_t i = 0; other != slot && i < text_size(other); i++){
+            if(buffer[i] != (char)('a' + other))
+                return false;
+        }
+    }
+    return true;
+}
+
+/** One write into a random slot, checked against the uncut text **/
+static void fuzz_once(uint32_t run){
+    char name[FUZZ_TEXT_MAX + 4], other[FUZZ_TEXT_MAX + 4];
+    char expected[3 * FUZZ_TEXT_MAX];
+    bool name_valid, other_valid;
+    random_name(name, &name_valid);
+    random_name(other, &other_valid);
+    int number = (int)(next_random() % 2000001) - 1000000;
+
+    TextSlot slot = below(TEXT_SLOT_COUNT);
+    mark_others(slot);
+    const char *text;
+    bool valid = name_valid;
+    bool cut = true;
+    switch(below(5)){
+        case 0:
+            snprintf(expected, sizeof(expected), "%s's Birthday!", name);
+            text = text_format_string(slot, STRING_BIRTHDAY_GREETING, "%s's Birthday!", name);
+            break;
+        case 1:
+            snprintf(expected, sizeof(expected), "%d %s to %s's birthday", number, other, name);
+            text = text_format_string(slot, STRING_COUNTDOWN_BIRTHDAY, "%d %s to %s's birthday", number, other, name);
+            valid = name_valid && other_valid;
+            break;
+        case 2:
+            snprintf(expected, sizeof(expected), "%s, %s %2d", name, other, number % 32);
+            text = TEXT_FORMAT(slot, "%s, %s %2d", name, other, number % 32);
+            valid = name_valid && other_valid;
+            break;
+        case 3:
+            snprintf(expected, sizeof(expected), "%d°C%s", number, name);
+            text = TEXT_FORMAT(slot, "%d°C%s", number, name);
+            break;
+        default: {
+            // The name as a strftime format, the time formats are the short case of this
+            time_t when = (time_t)(next_random() % 2000000000u);
+            struct tm tm = *gmtime(&when);
+            if(strftime(expected, sizeof(expected), name, &tm) == 0)
+                expected[0] = '\0';
+            text = text_strftime(slot, name, &tm);
+            // strftime doesn't cut, too long gives nothing
+            if(strlen(expected) >= text_size(slot))
+                expected[0] = '\0';
+            cut = false;
+            break;
+        }
+    }
+
+    size_t length = strlen(text);
+    if(text != text_buffer(slot) || text != text_get(slot))
+        fail(run, slot, "text isn't in its slot");
+    if(length >= text_size(slot))
+        fail(run, slot, "text overruns its slot");
+    if(strncmp(text, expected, length) != 0)
+        fail(run, slot, "text isn't a prefix of what was formatted");
+    if(valid && !valid_utf8(text))
+        fail(run, slot, "valid UTF-8 came out cut inside a character");
+    if(cut && valid && length < strlen(expected) && length + 4 < text_size(slot))
+        fail(run, slot, "text was cut short of a whole character that fit");
+    if(!others_intact(slot))
+        fail(run, slot, "a write reached another slot");
+}
+
+int main(void){
+    const char *runs_text = getenv("HOST_FUZZ_RUNS");
+    const char *seed_text = getenv("HOST_FUZZ_SEED");
+    uint32_t runs = runs_text != NULL ? (uint32_t)strtoul(runs_text, NULL, 10) : FUZZ_RUNS;
+    s_state = seed_text != NULL ? (uint32_t)strtoul(seed_text, NULL, 10) : 1;
+    if(s_state == 0)
+        s_state = 1;
+    // The English table, so the table formats are the ones checked
+    string_table_init();
+
+    for(uint32_t run = 0; run < runs && s_failures < 20; run++)
+        fuzz_once(run);
+    printf("fuzz_text: %u runs, %d failures\n", runs, s_failures);
+    fflush(NULL);
+    return s_failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+/*
+ * Controls for the host harnesses: the simulated clock, the services the
+ * face subscribes to, the phone's end of AppMessage and the counters the
+ * stub keeps. Harnesses that link the face define host_run(), it runs in
+ * place of app_event_loop() between the face's init and deinit.
+ */
+
+#include <pebble.h>
+
+/** What the stub counted since the start or the last host_reset_counters() **/
+typedef struct {
+    uint32_t allocs;
+    uint32_t frees;
+    size_t heap_used;
+    size_t heap_peak;
+    uint32_t persist_reads;
+    uint32_t persist_writes;
+    uint32_t persist_write_bytes;
+    uint32_t persist_failures;
+    uint32_t outbox_sends;
+    uint32_t inbox_messages;
+    uint32_t ticks;
+    uint32_t draws;
+} HostCounters;
+
+/** Runs between init and deinit, a weak default does nothing **/
+void host_run(void);
+
+/** Counters **/
+void host_get_counters(HostCounters *counters);
+void host_reset_counters(void);
+/** Calls to one stubbed function by name, since the last reset **/
+uint32_t host_calls(const char *name);
+/** Every stubbed function that was called, with its calls divided by per **/
+void host_report_calls(FILE *out, uint32_t per);
+/** Objects the face created and never destroyed, logged to out. Checked again at exit, where any fail the run **/
+uint32_t host_report_leaks(FILE *out);
+
+/** Checks **/
+/** Name the harness in its check output, its failures are reported at exit and fail the run **/
+void host_checks_begin(const char *name);
+/** Count a failed check and print what went wrong, unless ok **/
+void host_expect(bool ok, const char *what);
+
+/** Clock **/
+void host_set_time(time_t now);
+/** Move the clock on, firing every minute tick and timer on the way **/
+void host_advance(uint32_t seconds);
+/** One turn of the event loop: due timers, outbox acks, then drawing the dirty layers **/
+void host_idle(void);
+/** Nanoseconds on the host's monotonic clock, for timing the face **/
+uint64_t host_now_ns(void);
+
+/** Services **/
+void host_set_battery(uint8_t percent, bool charging);
+void host_set_connected(bool connected);
+
+/** The phone's end of AppMessage **/
+DictionaryIterator *host_inbox_begin(void);
+void host_inbox_deliver(void);
+/** Acknowledge the watch's messages on the next host_idle(), or fail them **/
+void host_set_outbox_ack(bool ack);
+/** Oldest message the watch sent that the harness hasn't looked at, false if none **/
+bool host_outbox_pop(DictionaryIterator *iterator);
+
+/** Persist **/
+/** Bytes the app has persisted, against HOST_PERSIST_QUOTA **/
+size_t host_persist_used(void);
+void host_persist_clear(void);
+
+// Per-app persist storage on the watch
+#define HOST_PERSIST_QUOTA 4096
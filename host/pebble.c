@@ -0,0 +1,1265 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdarg.h>
+#include "host.h"
+
+/*
+ * The Pebble calls the face makes, recorded instead of drawn. Objects come
+ * from malloc through host_alloc() so allocations, frees and leaks can be
+ * counted; persist is an in-memory map with the watch's per-key and per-app
+ * limits; the clock only moves when a harness moves it.
+ */
+
+#ifndef HOST_RESOURCES
+#define HOST_RESOURCES "resources"
+#endif
+
+#define HOST_CALL_SLOTS 160
+#define HOST_PERSIST_KEYS 256
+#define HOST_OUTBOX_QUEUE 16
+#define HOST_MESSAGE_MAX 2048
+#define HOST_HEAP_SIZE 24576
+#define HOST_DEFAULT_START 1735689600   // 2025-01-01 00:00 UTC
+
+#define HOST_CALL() host_count(__func__)
+
+/** Objects handed to the face **/
+
+typedef enum {
+    OBJECT_LAYER,
+    OBJECT_TEXT_LAYER,
+    OBJECT_BITMAP_LAYER,
+    OBJECT_WINDOW,
+    OBJECT_BITMAP,
+    OBJECT_TIMER,
+    OBJECT_KIND_COUNT
+} ObjectKind;
+
+static const char *const s_kind_names[OBJECT_KIND_COUNT] = {
+    "Layer", "TextLayer", "BitmapLayer", "Window", "GBitmap", "AppTimer",
+};
+
+typedef struct {
+    size_t size;
+    ObjectKind kind;
+} Allocation;
+
+struct Layer {
+    GRect frame;
+    LayerUpdateProc update_proc;
+    bool hidden;
+    bool dirty;
+    TextLayer *text_layer;
+};
+
+struct TextLayer {
+    Layer layer;
+    const char *text;
+};
+
+struct BitmapLayer {
+    Layer layer;
+    const GBitmap *bitmap;
+};
+
+struct Window {
+    Layer *root;
+    WindowHandlers handlers;
+    bool loaded;
+};
+
+struct GBitmap {
+    GSize size;
+    GBitmapFormat format;
+    uint16_t stride;
+    uint8_t *data;
+    bool owns_data;
+};
+
+struct GContext {
+    GBitmap *frame_buffer;
+};
+
+struct AppTimer {
+    uint64_t due_ms;
+    AppTimerCallback callback;
+    void *data;
+    AppTimer *next;
+};
+
+typedef struct {
+    const char *name;
+    uint32_t calls;
+} CallCount;
+
+typedef struct {
+    uint32_t key;
+    uint16_t size;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistValue;
+
+static const char *const s_resource_files[] = HOST_RESOURCE_FILES;
+
+static HostCounters s_counters;
+static uint32_t s_live[OBJECT_KIND_COUNT];
+static CallCount s_calls[HOST_CALL_SLOTS];
+static int s_call_count;
+
+static time_t s_clock = HOST_DEFAULT_START;
+static uint16_t s_clock_ms;
+static AppTimer *s_timers;
+
+static Layer **s_layers;
+static int s_layer_count;
+static int s_layer_capacity;
+static GBitmap s_frame_buffer;
+static GContext s_context = { &s_frame_buffer };
+
+static TickHandler s_tick_handler;
+static TimeUnits s_tick_units;
+static BatteryStateHandler s_battery_handler;
+static BatteryChargeState s_battery = { 80, false, false };
+static BluetoothConnectionHandler s_bluetooth_handler;
+static bool s_connected = true;
+
+static PersistValue s_persist[HOST_PERSIST_KEYS];
+static int s_persist_count;
+
+static AppMessageInboxReceived s_inbox_received;
+static AppMessageInboxDropped s_inbox_dropped;
+static AppMessageOutboxSent s_outbox_sent;
+static AppMessageOutboxFailed s_outbox_failed;
+static uint32_t s_inbox_size;
+static uint32_t s_outbox_size;
+static bool s_outbox_writing;
+static bool s_outbox_in_flight;
+static bool s_outbox_ack = true;
+static uint8_t s_outbox[HOST_MESSAGE_MAX];
+static DictionaryIterator s_outbox_iter;
+static uint8_t s_inbox[HOST_MESSAGE_MAX];
+static DictionaryIterator s_inbox_iter;
+static uint8_t s_sent[HOST_OUTBOX_QUEUE][HOST_MESSAGE_MAX];
+static size_t s_sent_size[HOST_OUTBOX_QUEUE];
+static int s_sent_head;
+static int s_sent_count;
+
+/** Harness plumbing **/
+
+static void host_count(const char *name){
+    for(int i = 0; i < s_call_count; i++){
+        if(s_calls[i].name == name || strcmp(s_calls[i].name, name) == 0){
+            s_calls[i].calls++;
+            return;
+        }
+    }
+    if(s_call_count < HOST_CALL_SLOTS)
+        s_calls[s_call_count++] = (CallCount){ name, 1 };
+}
+
+static void *host_alloc(ObjectKind kind, size_t size){
+    Allocation *allocation = calloc(1, sizeof(Allocation) + size);
+    if(allocation == NULL){
+        fprintf(stderr, "host: out of memory\n");
+        exit(2);
+    }
+    allocation->size = size;
+    allocation->kind = kind;
+    s_counters.allocs++;
+    s_counters.heap_used += size;
+    if(s_counters.heap_used > s_counters.heap_peak)
+        s_counters.heap_peak = s_counters.heap_used;
+    s_live[kind]++;
+    return allocation + 1;
+}
+
+static void host_free(void *object){
+    if(object == NULL)
+        return;
+    Allocation *allocation = (Allocation *)object - 1;
+    s_counters.frees++;
+    s_counters.heap_used -= allocation->size;
+    s_live[allocation->kind]--;
+    free(allocation);
+}
+
+static void track_layer(Layer *layer){
+    if(s_layer_count == s_layer_capacity){
+        s_layer_capacity = s_layer_capacity ? s_layer_capacity * 2 : 16;
+        s_layers = realloc(s_layers, s_layer_capacity * sizeof(Layer *));
+    }
+    s_layers[s_layer_count++] = layer;
+}
+
+static void untrack_layer(Layer *layer){
+    for(int i = 0; i < s_layer_count; i++){
+        if(s_layers[i] == layer){
+            s_layers[i] = s_layers[--s_layer_count];
+            return;
+        }
+    }
+}
+
+__attribute__((weak)) void host_run(void){
+}
+
+void host_get_counters(HostCounters *counters){
+    *counters = s_counters;
+}
+
+void host_reset_counters(void){
+    size_t used = s_counters.heap_used;
+    s_counters = (HostCounters){ .heap_used = used, .heap_peak = used };
+    for(int i = 0; i < s_call_count; i++)
+        s_calls[i].calls = 0;
+}
+
+uint32_t host_calls(const char *name){
+    for(int i = 0; i < s_call_count; i++){
+        if(strcmp(s_calls[i].name, name) == 0)
+            return s_calls[i].calls;
+    }
+    return 0;
+}
+
+static int compare_calls(const void *a, const void *b){
+    const CallCount *left = a, *right = b;
+    if(left->calls != right->calls)
+        return left->calls < right->calls ? 1 : -1;
+    return strcmp(left->name, right->name);
+}
+
+void host_report_calls(FILE *out, uint32_t per){
+    CallCount sorted[HOST_CALL_SLOTS];
+    memcpy(sorted, s_calls, sizeof(sorted));
+    qsort(sorted, s_call_count, sizeof(CallCount), compare_calls);
+    for(int i = 0; i < s_call_count; i++){
+        if(sorted[i].calls == 0)
+            continue;
+        if(per > 1)
+            fprintf(out, "  %-40s %10u %12.3f\n", sorted[i].name, sorted[i].calls, (double)sorted[i].calls / per);
+        else
+            fprintf(out, "  %-40s %10u\n", sorted[i].name, sorted[i].calls);
+    }
+}
+
+uint32_t host_report_leaks(FILE *out){
+    uint32_t leaks = 0;
+    for(int kind = 0; kind < OBJECT_KIND_COUNT; kind++){
+        // Timers still pending belong to the event loop, not the face
+        if(kind == OBJECT_TIMER || s_live[kind] == 0)
+            continue;
+        fprintf(out, "  leaked %u %s\n", s_live[kind], s_kind_names[kind]);
+        leaks += s_live[kind];
+    }
+    return leaks;
+}
+
+uint64_t host_now_ns(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/** Clock and event loop **/
+
+#undef time
+time_t host_time(time_t *now){
+    HOST_CALL();
+    if(now != NULL)
+        *now = s_clock;
+    return s_clock;
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms){
+    HOST_CALL();
+    if(t_utc != NULL)
+        *t_utc = s_clock;
+    if(out_ms != NULL)
+        *out_ms = s_clock_ms;
+    return s_clock_ms;
+}
+
+static uint64_t clock_ms(void){
+    return (uint64_t)s_clock * 1000 + s_clock_ms;
+}
+
+void host_set_time(time_t now){
+    s_clock = now;
+    s_clock_ms = 0;
+}
+
+static void run_timers(void){
+    // Callbacks may register new timers, those wait for the next turn
+    uint64_t now = clock_ms();
+    AppTimer *due = NULL, **link = &s_timers;
+    while(*link != NULL){
+        AppTimer *timer = *link;
+        if(timer->due_ms <= now){
+            *link = timer->next;
+            timer->next = due;
+            due = timer;
+        }else{
+            link = &timer->next;
+        }
+    }
+    while(due != NULL){
+        AppTimer *timer = due;
+        due = timer->next;
+        AppTimerCallback callback = timer->callback;
+        void *data = timer->data;
+        host_free(timer);
+        callback(data);
+    }
+}
+
+static void draw_layers(void){
+    for(int i = 0; i < s_layer_count; i++){
+        Layer *layer = s_layers[i];
+        if(!layer->dirty)
+            continue;
+        layer->dirty = false;
+        if(layer->hidden)
+            continue;
+        s_counters.draws++;
+        if(layer->update_proc != NULL)
+            layer->update_proc(layer, &s_context);
+        else if(layer->text_layer != NULL && layer->text_layer->text != NULL)
+            graphics_draw_text(&s_context, layer->text_layer->text, NULL, layer->frame,
+                               GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
+    }
+}
+
+static void deliver_acks(void){
+    if(!s_outbox_in_flight)
+        return;
+    s_outbox_in_flight = false;
+    DictionaryIterator iter = s_outbox_iter;
+    if(s_outbox_ack){
+        if(s_outbox_sent != NULL)
+            s_outbox_sent(&iter, NULL);
+    }else if(s_outbox_failed != NULL){
+        s_outbox_failed(&iter, APP_MSG_SEND_TIMEOUT, NULL);
+    }
+}
+
+void host_idle(void){
+    run_timers();
+    deliver_acks();
+    run_timers();
+    draw_layers();
+}
+
+static TimeUnits units_between(const struct tm *before, const struct tm *after){
+    TimeUnits units = SECOND_UNIT;
+    if(before->tm_min != after->tm_min || before->tm_hour != after->tm_hour || before->tm_yday != after->tm_yday)
+        units |= MINUTE_UNIT;
+    if(before->tm_hour != after->tm_hour || before->tm_yday != after->tm_yday)
+        units |= HOUR_UNIT;
+    if(before->tm_yday != after->tm_yday || before->tm_year != after->tm_year)
+        units |= DAY_UNIT;
+    if(before->tm_mon != after->tm_mon || before->tm_year != after->tm_year)
+        units |= MONTH_UNIT;
+    if(before->tm_year != after->tm_year)
+        units |= YEAR_UNIT;
+    return units;
+}
+
+void host_advance(uint32_t seconds){
+    time_t end = s_clock + seconds;
+    while(s_clock < end){
+        // Step to the next minute or the next timer, whichever comes first
+        time_t next = s_clock - s_clock % SECONDS_PER_MINUTE + SECONDS_PER_MINUTE;
+        for(AppTimer *timer = s_timers; timer != NULL; timer = timer->next){
+            time_t due = (time_t)(timer->due_ms / 1000);
+            if(due > s_clock && due < next)
+                next = due;
+        }
+        if(next > end)
+            next = end;
+
+        struct tm before = *localtime(&s_clock);
+        s_clock = next;
+        s_clock_ms = 0;
+        struct tm after = *localtime(&s_clock);
+
+        TimeUnits units = units_between(&before, &after);
+        if(s_tick_handler != NULL && (units & s_tick_units) != 0 && (units & MINUTE_UNIT) != 0){
+            s_counters.ticks++;
+            s_tick_handler(&after, units);
+        }
+        host_idle();
+    }
+}
+
+void app_event_loop(void){
+    HOST_CALL();
+    host_idle();
+    host_run();
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data){
+    HOST_CALL();
+    AppTimer *timer = host_alloc(OBJECT_TIMER, sizeof(AppTimer));
+    timer->due_ms = clock_ms() + timeout_ms;
+    timer->callback = callback;
+    timer->data = callback_data;
+    timer->next = s_timers;
+    s_timers = timer;
+    return timer;
+}
+
+void app_timer_cancel(AppTimer *timer_handle){
+    HOST_CALL();
+    for(AppTimer **link = &s_timers; *link != NULL; link = &(*link)->next){
+        if(*link == timer_handle){
+            *link = timer_handle->next;
+            host_free(timer_handle);
+            return;
+        }
+    }
+}
+
+/** Logging **/
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...){
+    HOST_CALL();
+    static int verbose = -1;
+    if(verbose < 0)
+        verbose = getenv("HOST_VERBOSE") != NULL;
+    if(!verbose && log_level > APP_LOG_LEVEL_WARNING)
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "[%s:%d] ", src_filename, src_line_number);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+/** Services **/
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler){
+    HOST_CALL();
+    s_tick_units = tick_units;
+    s_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void){
+    HOST_CALL();
+    s_tick_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void){
+    HOST_CALL();
+    return s_battery;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler){
+    HOST_CALL();
+    s_battery_handler = handler;
+}
+
+void host_set_battery(uint8_t percent, bool charging){
+    s_battery = (BatteryChargeState){ percent, charging, charging };
+    if(s_battery_handler != NULL)
+        s_battery_handler(s_battery);
+}
+
+bool bluetooth_connection_service_peek(void){
+    HOST_CALL();
+    return s_connected;
+}
+
+void bluetooth_connection_service_subscribe(BluetoothConnectionHandler handler){
+    HOST_CALL();
+    s_bluetooth_handler = handler;
+}
+
+void host_set_connected(bool connected){
+    s_connected = connected;
+    if(s_bluetooth_handler != NULL)
+        s_bluetooth_handler(connected);
+}
+
+void vibes_double_pulse(void){
+    HOST_CALL();
+}
+
+/** Memory **/
+
+size_t heap_bytes_used(void){
+    HOST_CALL();
+    return s_counters.heap_used;
+}
+
+size_t heap_bytes_free(void){
+    HOST_CALL();
+    return s_counters.heap_used < HOST_HEAP_SIZE ? HOST_HEAP_SIZE - s_counters.heap_used : 0;
+}
+
+/** Resources **/
+
+static FILE *open_resource(uint32_t resource_id, const char *variant){
+    if(resource_id == 0 || resource_id >= ARRAY_LENGTH(s_resource_files))
+        return NULL;
+    char path[512];
+    const char *file = s_resource_files[resource_id];
+    const char *dot = strrchr(file, '.');
+    if(variant != NULL && dot != NULL){
+        snprintf(path, sizeof(path), "%s/%.*s%s%s", HOST_RESOURCES, (int)(dot - file), file, variant, dot);
+        FILE *f = fopen(path, "rb");
+        if(f != NULL)
+            return f;
+    }
+    snprintf(path, sizeof(path), "%s/%s", HOST_RESOURCES, file);
+    return fopen(path, "rb");
+}
+
+ResHandle resource_get_handle(uint32_t resource_id){
+    HOST_CALL();
+    return (ResHandle)(uintptr_t)resource_id;
+}
+
+size_t resource_size(ResHandle handle){
+    HOST_CALL();
+    FILE *f = open_resource((uint32_t)(uintptr_t)handle, NULL);
+    if(f == NULL)
+        return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size < 0 ? 0 : (size_t)size;
+}
+
+size_t resource_load_byte_range(ResHandle handle, uint32_t start_offset, uint8_t *buffer, size_t num_bytes){
+    HOST_CALL();
+    FILE *f = open_resource((uint32_t)(uintptr_t)handle, NULL);
+    if(f == NULL)
+        return 0;
+    size_t read = 0;
+    if(fseek(f, start_offset, SEEK_SET) == 0)
+        read = fread(buffer, 1, num_bytes, f);
+    fclose(f);
+    return read;
+}
+
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length){
+    return resource_load_byte_range(handle, 0, buffer, max_length);
+}
+
+const char *i18n_get_system_locale(void){
+    HOST_CALL();
+    const char *locale = getenv("HOST_LOCALE");
+    return locale != NULL ? locale : "en_US";
+}
+
+GFont fonts_get_system_font(const char *font_key){
+    HOST_CALL();
+    return (GFont)font_key;
+}
+
+/** Bitmaps, sized like the decoded images: 1-bit on aplite, palettized on basalt **/
+
+#ifdef PBL_PLATFORM_APLITE
+#define BITMAP_VARIANT "~bw"
+#else
+#define BITMAP_VARIANT "~color"
+#endif
+
+static int bitmap_depth(GBitmapFormat format){
+    switch(format){
+        case GBitmapFormat8Bit: return 8;
+        case GBitmapFormat2BitPalette: return 2;
+        case GBitmapFormat4BitPalette: return 4;
+        default: return 1;
+    }
+}
+
+static GBitmap *bitmap_create(GSize size, GBitmapFormat format){
+    int depth = bitmap_depth(format);
+    uint16_t stride = format == GBitmapFormat1Bit ? ((size.w + 31) / 32) * 4 : (size.w * depth + 7) / 8;
+    size_t palette = format >= GBitmapFormat1BitPalette ? (size_t)1 << depth : 0;
+    GBitmap *bitmap = host_alloc(OBJECT_BITMAP, sizeof(GBitmap) + (size_t)stride * size.h + palette);
+    bitmap->size = size;
+    bitmap->format = format;
+    bitmap->stride = stride;
+    bitmap->data = (uint8_t *)(bitmap + 1);
+    return bitmap;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id){
+    HOST_CALL();
+    FILE *f = open_resource(resource_id, BITMAP_VARIANT);
+    if(f == NULL)
+        return NULL;
+    uint8_t header[26];
+    size_t read = fread(header, 1, sizeof(header), f);
+    fclose(f);
+    if(read != sizeof(header) || memcmp(header + 12, "IHDR", 4) != 0)
+        return NULL;
+    int width = header[16] << 24 | header[17] << 16 | header[18] << 8 | header[19];
+    int height = header[20] << 24 | header[21] << 16 | header[22] << 8 | header[23];
+    // tools/assets.py writes grey 1-bit for ~bw and palettes of up to 16 colors for ~color
+    GBitmapFormat format = GBitmapFormat1Bit;
+    if(header[25] == 3)
+        format = header[24] == 4 ? GBitmapFormat4BitPalette :
+                 header[24] == 2 ? GBitmapFormat2BitPalette : GBitmapFormat1BitPalette;
+    return bitmap_create(GSize(width, height), format);
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format){
+    HOST_CALL();
+    return bitmap_create(size, format);
+}
+
+void gbitmap_destroy(GBitmap *bitmap){
+    HOST_CALL();
+    host_free(bitmap);
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap){
+    HOST_CALL();
+    return (GRect){ GPoint(0, 0), bitmap->size };
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap){
+    HOST_CALL();
+    return bitmap->stride;
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap){
+    HOST_CALL();
+    return bitmap->data;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap){
+    HOST_CALL();
+    return bitmap->format;
+}
+
+/** Drawing, counted only **/
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx){
+    HOST_CALL();
+    if(ctx->frame_buffer->data == NULL){
+        static uint8_t pixels[20 * 168];
+        *ctx->frame_buffer = (GBitmap){ GSize(144, 168), GBitmapFormat1Bit, 20, pixels, false };
+    }
+    return ctx->frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer){
+    HOST_CALL();
+    return true;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color){
+    HOST_CALL();
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color){
+    HOST_CALL();
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color){
+    HOST_CALL();
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode){
+    HOST_CALL();
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask){
+    HOST_CALL();
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect){
+    HOST_CALL();
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont font, GRect box,
+                        GTextOverflowMode overflow_mode, GTextAlignment alignment, void *text_attributes){
+    HOST_CALL();
+}
+
+/** Layers **/
+
+static void layer_init(Layer *layer, GRect frame){
+    layer->frame = frame;
+    layer->dirty = true;
+    track_layer(layer);
+}
+
+Layer *layer_create(GRect frame){
+    HOST_CALL();
+    Layer *layer = host_alloc(OBJECT_LAYER, sizeof(Layer));
+    layer_init(layer, frame);
+    return layer;
+}
+
+void layer_destroy(Layer *layer){
+    HOST_CALL();
+    if(layer == NULL)
+        return;
+    untrack_layer(layer);
+    host_free(layer);
+}
+
+void layer_add_child(Layer *parent, Layer *child){
+    HOST_CALL();
+}
+
+void layer_mark_dirty(Layer *layer){
+    HOST_CALL();
+    layer->dirty = true;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc){
+    HOST_CALL();
+    layer->update_proc = update_proc;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden){
+    HOST_CALL();
+    if(layer->hidden != hidden)
+        layer->dirty = true;
+    layer->hidden = hidden;
+}
+
+GRect layer_get_bounds(const Layer *layer){
+    HOST_CALL();
+    return (GRect){ GPoint(0, 0), layer->frame.size };
+}
+
+GRect layer_get_frame(const Layer *layer){
+    HOST_CALL();
+    return layer->frame;
+}
+
+TextLayer *text_layer_create(GRect frame){
+    HOST_CALL();
+    TextLayer *text_layer = host_alloc(OBJECT_TEXT_LAYER, sizeof(TextLayer));
+    layer_init(&text_layer->layer, frame);
+    text_layer->layer.text_layer = text_layer;
+    return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer){
+    HOST_CALL();
+    if(text_layer == NULL)
+        return;
+    untrack_layer(&text_layer->layer);
+    host_free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer){
+    HOST_CALL();
+    return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text){
+    HOST_CALL();
+    text_layer->text = text;
+    text_layer->layer.dirty = true;
+}
+
+const char *text_layer_get_text(TextLayer *text_layer){
+    HOST_CALL();
+    return text_layer->text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color){
+    HOST_CALL();
+    text_layer->layer.dirty = true;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color){
+    HOST_CALL();
+    text_layer->layer.dirty = true;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font){
+    HOST_CALL();
+    text_layer->layer.dirty = true;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment){
+    HOST_CALL();
+    text_layer->layer.dirty = true;
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame){
+    HOST_CALL();
+    BitmapLayer *bitmap_layer = host_alloc(OBJECT_BITMAP_LAYER, sizeof(BitmapLayer));
+    layer_init(&bitmap_layer->layer, frame);
+    return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer){
+    HOST_CALL();
+    if(bitmap_layer == NULL)
+        return;
+    untrack_layer(&bitmap_layer->layer);
+    host_free(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer){
+    HOST_CALL();
+    return (Layer *)&bitmap_layer->layer;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap){
+    HOST_CALL();
+    bitmap_layer->bitmap = bitmap;
+    bitmap_layer->layer.dirty = true;
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode){
+    HOST_CALL();
+    bitmap_layer->layer.dirty = true;
+}
+
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color){
+    HOST_CALL();
+    bitmap_layer->layer.dirty = true;
+}
+
+/** Windows, pushing one loads it right away **/
+
+Window *window_create(void){
+    HOST_CALL();
+    Window *window = host_alloc(OBJECT_WINDOW, sizeof(Window));
+    window->root = layer_create(GRect(0, 0, 144, 168));
+    return window;
+}
+
+void window_destroy(Window *window){
+    HOST_CALL();
+    if(window == NULL)
+        return;
+    if(window->loaded && window->handlers.unload != NULL)
+        window->handlers.unload(window);
+    layer_destroy(window->root);
+    host_free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers){
+    HOST_CALL();
+    window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color){
+    HOST_CALL();
+    window->root->dirty = true;
+}
+
+Layer *window_get_root_layer(const Window *window){
+    HOST_CALL();
+    return window->root;
+}
+
+void window_stack_push(Window *window, bool animated){
+    HOST_CALL();
+    if(!window->loaded && window->handlers.load != NULL)
+        window->handlers.load(window);
+    window->loaded = true;
+    if(window->handlers.appear != NULL)
+        window->handlers.appear(window);
+}
+
+/** Persist, with the watch's limits **/
+
+static PersistValue *persist_find(uint32_t key){
+    for(int i = 0; i < s_persist_count; i++){
+        if(s_persist[i].key == key)
+            return &s_persist[i];
+    }
+    return NULL;
+}
+
+size_t host_persist_used(void){
+    size_t used = 0;
+    for(int i = 0; i < s_persist_count; i++)
+        used += s_persist[i].size;
+    return used;
+}
+
+void host_persist_clear(void){
+    s_persist_count = 0;
+}
+
+bool persist_exists(const uint32_t key){
+    HOST_CALL();
+    return persist_find(key) != NULL;
+}
+
+int persist_get_size(const uint32_t key){
+    HOST_CALL();
+    PersistValue *value = persist_find(key);
+    return value != NULL ? value->size : E_DOES_NOT_EXIST;
+}
+
+status_t persist_delete(const uint32_t key){
+    HOST_CALL();
+    PersistValue *value = persist_find(key);
+    if(value == NULL)
+        return E_DOES_NOT_EXIST;
+    *value = s_persist[--s_persist_count];
+    return S_TRUE;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size){
+    HOST_CALL();
+    s_counters.persist_reads++;
+    PersistValue *value = persist_find(key);
+    if(value == NULL)
+        return E_DOES_NOT_EXIST;
+    size_t size = value->size < buffer_size ? value->size : buffer_size;
+    memcpy(buffer, value->data, size);
+    return (int)size;
+}
+
+int persist_read_string(const uint32_t key, char *buffer, const size_t buffer_size){
+    int size = persist_read_data(key, buffer, buffer_size);
+    if(size > 0)
+        buffer[(size_t)size < buffer_size ? (size_t)size - 1 : buffer_size - 1] = '\0';
+    return size;
+}
+
+bool persist_read_bool(const uint32_t key){
+    bool value = false;
+    persist_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+int32_t persist_read_int(const uint32_t key){
+    int32_t value = 0;
+    persist_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size){
+    HOST_CALL();
+    s_counters.persist_writes++;
+    size_t length = size < PERSIST_DATA_MAX_LENGTH ? size : PERSIST_DATA_MAX_LENGTH;
+    PersistValue *value = persist_find(key);
+    size_t used = host_persist_used() - (value != NULL ? value->size : 0);
+    if(used + length > HOST_PERSIST_QUOTA || (value == NULL && s_persist_count == HOST_PERSIST_KEYS)){
+        s_counters.persist_failures++;
+        return E_OUT_OF_STORAGE;
+    }
+    if(value == NULL){
+        value = &s_persist[s_persist_count++];
+        value->key = key;
+    }
+    value->size = length;
+    memcpy(value->data, data, length);
+    s_counters.persist_write_bytes += length;
+    return (int)length;
+}
+
+int persist_write_string(const uint32_t key, const char *cstring){
+    return persist_write_data(key, cstring, strlen(cstring) + 1);
+}
+
+status_t persist_write_bool(const uint32_t key, const bool value){
+    int written = persist_write_data(key, &value, sizeof(value));
+    return written < 0 ? written : S_SUCCESS;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value){
+    int written = persist_write_data(key, &value, sizeof(value));
+    return written < 0 ? written : S_SUCCESS;
+}
+
+/** Persist survives runs through a file when HOST_PERSIST names one **/
+
+static void persist_save(void){
+    const char *path = getenv("HOST_PERSIST");
+    FILE *f = path != NULL ? fopen(path, "wb") : NULL;
+    if(f == NULL)
+        return;
+    for(int i = 0; i < s_persist_count; i++){
+        fwrite(&s_persist[i].key, sizeof(uint32_t), 1, f);
+        fwrite(&s_persist[i].size, sizeof(uint16_t), 1, f);
+        fwrite(s_persist[i].data, 1, s_persist[i].size, f);
+    }
+    fclose(f);
+}
+
+/** Checks **/
+
+static const char *s_check_name;
+static int s_check_failures;
+
+void host_checks_begin(const char *name){
+    s_check_name = name;
+    s_check_failures = 0;
+}
+
+void host_expect(bool ok, const char *what){
+    if(!ok){
+        fprintf(stderr, "%s: %s\n", s_check_name != NULL ? s_check_name : "host", what);
+        s_check_failures++;
+    }
+}
+
+/** Runs after the face's main returned, failed checks and leaks fail the run **/
+static void host_finish(void){
+    persist_save();
+    if(s_check_name != NULL){
+        printf("%s: %d failures\n", s_check_name, s_check_failures);
+        if(s_check_failures > 0){
+            fflush(NULL);
+            _Exit(1);
+        }
+    }
+    if(host_report_leaks(stderr) > 0){
+        fflush(NULL);
+        _Exit(3);
+    }
+}
+
+// Ahead of the harnesses' constructors, so they see the clock and persist set up
+__attribute__((constructor(101))) static void host_start(void){
+    setenv("TZ", "UTC", 1);
+    tzset();
+    const char *start = getenv("HOST_START");
+    if(start != NULL)
+        s_clock = (time_t)strtoll(start, NULL, 10);
+
+    const char *path = getenv("HOST_PERSIST");
+    FILE *f = path != NULL ? fopen(path, "rb") : NULL;
+    if(f != NULL){
+        PersistValue value;
+        while(s_persist_count < HOST_PERSIST_KEYS &&
+              fread(&value.key, sizeof(uint32_t), 1, f) == 1 && fread(&value.size, sizeof(uint16_t), 1, f) == 1 &&
+              value.size <= PERSIST_DATA_MAX_LENGTH && fread(value.data, 1, value.size, f) == value.size)
+            s_persist[s_persist_count++] = value;
+        fclose(f);
+    }
+    atexit(host_finish);
+}
+
+/** Dictionaries **/
+
+static void dict_begin(DictionaryIterator *iter, uint8_t *buffer, size_t size){
+    iter->dictionary = (Dictionary *)buffer;
+    iter->dictionary->count = 0;
+    iter->cursor = iter->dictionary->head;
+    iter->end = buffer + size;
+}
+
+static DictionaryResult dict_write(DictionaryIterator *iter, uint32_t key, TupleType type, const void *data, uint16_t size){
+    uint8_t *cursor = (uint8_t *)iter->cursor;
+    if(cursor + sizeof(Tuple) + size > (const uint8_t *)iter->end)
+        return DICT_NOT_ENOUGH_STORAGE;
+    Tuple *tuple = (Tuple *)cursor;
+    tuple->key = key;
+    tuple->type = type;
+    tuple->length = size;
+    memcpy(tuple->value, data, size);
+    iter->dictionary->count++;
+    iter->cursor = (Tuple *)(cursor + sizeof(Tuple) + size);
+    return DICT_OK;
+}
+
+/** Close a dictionary being written, end then marks its last byte **/
+static void dict_end(DictionaryIterator *iter){
+    iter->end = iter->cursor;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *data, const uint16_t size){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *cstring){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_CSTRING, cstring, strlen(cstring) + 1);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int8(DictionaryIterator *iter, const uint32_t key, const int8_t value){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int16(DictionaryIterator *iter, const uint32_t key, const int16_t value){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value){
+    HOST_CALL();
+    return dict_write(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+static Tuple *tuple_next(const DictionaryIterator *iter, Tuple *tuple){
+    uint8_t *next = (uint8_t *)tuple + sizeof(Tuple) + tuple->length;
+    return next < (const uint8_t *)iter->end ? (Tuple *)next : NULL;
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter){
+    HOST_CALL();
+    if(iter->dictionary->count == 0)
+        return NULL;
+    iter->cursor = iter->dictionary->head;
+    return iter->cursor;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter){
+    HOST_CALL();
+    if(iter->cursor == NULL)
+        return NULL;
+    iter->cursor = tuple_next(iter, iter->cursor);
+    return iter->cursor;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key){
+    HOST_CALL();
+    Tuple *tuple = iter->dictionary->count > 0 ? iter->dictionary->head : NULL;
+    for(; tuple != NULL; tuple = tuple_next(iter, tuple)){
+        if(tuple->key == key)
+            return tuple;
+    }
+    return NULL;
+}
+
+/** AppMessage, the harness plays the phone **/
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound){
+    HOST_CALL();
+    if(size_inbound > HOST_MESSAGE_MAX || size_outbound > HOST_MESSAGE_MAX)
+        return APP_MSG_OUT_OF_MEMORY;
+    s_inbox_size = size_inbound;
+    s_outbox_size = size_outbound;
+    s_counters.heap_used += size_inbound + size_outbound;
+    if(s_counters.heap_used > s_counters.heap_peak)
+        s_counters.heap_peak = s_counters.heap_used;
+    return APP_MSG_OK;
+}
+
+uint32_t app_message_inbox_size_maximum(void){
+    HOST_CALL();
+    return 656;
+}
+
+uint32_t app_message_outbox_size_maximum(void){
+    HOST_CALL();
+    return 656;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator){
+    HOST_CALL();
+    if(s_outbox_size == 0)
+        return APP_MSG_INVALID_ARGS;
+    if(s_outbox_writing || s_outbox_in_flight)
+        return APP_MSG_BUSY;
+    dict_begin(&s_outbox_iter, s_outbox, s_outbox_size);
+    s_outbox_writing = true;
+    *iterator = &s_outbox_iter;
+    return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void){
+    HOST_CALL();
+    if(!s_outbox_writing)
+        return APP_MSG_INVALID_ARGS;
+    s_outbox_writing = false;
+    if(!s_connected)
+        return APP_MSG_NOT_CONNECTED;
+    dict_end(&s_outbox_iter);
+    s_outbox_in_flight = true;
+    s_counters.outbox_sends++;
+
+    // A copy for the harness to read, the oldest goes when the queue is full
+    size_t size = (const uint8_t *)s_outbox_iter.end - s_outbox;
+    int slot = (s_sent_head + s_sent_count) % HOST_OUTBOX_QUEUE;
+    if(s_sent_count == HOST_OUTBOX_QUEUE)
+        s_sent_head = (s_sent_head + 1) % HOST_OUTBOX_QUEUE;
+    else
+        s_sent_count++;
+    memcpy(s_sent[slot], s_outbox, size);
+    s_sent_size[slot] = size;
+    return APP_MSG_OK;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback){
+    HOST_CALL();
+    AppMessageInboxReceived previous = s_inbox_received;
+    s_inbox_received = received_callback;
+    return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback){
+    HOST_CALL();
+    AppMessageInboxDropped previous = s_inbox_dropped;
+    s_inbox_dropped = dropped_callback;
+    return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback){
+    HOST_CALL();
+    AppMessageOutboxSent previous = s_outbox_sent;
+    s_outbox_sent = sent_callback;
+    return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback){
+    HOST_CALL();
+    AppMessageOutboxFailed previous = s_outbox_failed;
+    s_outbox_failed = failed_callback;
+    return previous;
+}
+
+DictionaryIterator *host_inbox_begin(void){
+    dict_begin(&s_inbox_iter, s_inbox, sizeof(s_inbox));
+    return &s_inbox_iter;
+}
+
+void host_inbox_deliver(void){
+    dict_end(&s_inbox_iter);
+    size_t size = (const uint8_t *)s_inbox_iter.end - s_inbox;
+    if(size > s_inbox_size){
+        if(s_inbox_dropped != NULL)
+            s_inbox_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+        return;
+    }
+    s_counters.inbox_messages++;
+    if(s_inbox_received != NULL){
+        DictionaryIterator iter = s_inbox_iter;
+        s_inbox_received(&iter, NULL);
+    }
+}
+
+void host_set_outbox_ack(bool ack){
+    s_outbox_ack = ack;
+}
+
+bool host_outbox_pop(DictionaryIterator *iterator){
+    static uint8_t popped[HOST_MESSAGE_MAX];
+    if(s_sent_count == 0)
+        return false;
+    memcpy(popped, s_sent[s_sent_head], s_sent_size[s_sent_head]);
+    iterator->dictionary = (Dictionary *)popped;
+    iterator->cursor = NULL;
+    iterator->end = popped + s_sent_size[s_sent_head];
+    s_sent_head = (s_sent_head + 1) % HOST_OUTBOX_QUEUE;
+    s_sent_count--;
+    return true;
+}
@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+#
+# Writes the resource_ids.auto.h the host build compiles against, the way
+# the SDK numbers appinfo.json's media: RESOURCE_ID_<name> from 1 in order.
+# HOST_RESOURCE_FILES maps each id back to its file under resources/.
+#
+# Plain python (2 or 3), standard library only.
+#
+
+import json
+import sys
+
+
+def header(appinfo):
+    media = appinfo['resources']['media']
+    lines = [
+        '#pragma once',
+        '',
+        '// Generated by host/resource_ids.py from appinfo.json',
+        '',
+        'typedef enum {',
+        '    RESOURCE_ID_INVALID = 0,',
+    ]
+    for index, entry in enumerate(media):
+        lines.append('    RESOURCE_ID_%s = %d,' % (entry['name'], index + 1))
+    lines.append('} ResourceId;')
+    lines.append('')
+    lines.append('#define HOST_RESOURCE_FILES { NULL, \\')
+    for entry in media:
+        lines.append('    "%s", \\' % entry['file'])
+    lines.append('}')
+    return '\n'.join(lines) + '\n'
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('usage: resource_ids.py <appinfo.json> <header>\n')
+        return 2
+    with open(argv[1]) as f:
+        text = header(json.load(f))
+    try:
+        with open(argv[2]) as f:
+            if f.read() == text:
+                return 0
+    except IOError:
+        pass
+    with open(argv[2], 'w') as f:
+        f.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
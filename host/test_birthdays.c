@@ -0,0 +1,120 @@
+#include "host.h"
+#include "holidays.h"
+#include "calendar.h"
+#include "birthdays.h"
+#include "messages.h"
+
+/*
+ * Fills the birthday index next to everything else the face persists and
+ * checks it all fits the quota, then shrinks the list and checks the keys
+ * the longer one used are gone. Transfers that stop halfway or lose
+ * records have to leave the list as it was.
+ */
+
+#define YEAR 2025
+#define CALENDAR_DAYS 96
+#define FULL 0x01
+#define LAST 0x02
+#define KEY_TEMPERATURE 0
+#define KEY_BDAY_ENTRIES 31
+#define KEY_BDAY_NAMES 40
+#define NAME "Birthday!"
+#define NAME_LEN 9
+
+static void send_calendar(void){
+    uint8_t chunk[7 + CALENDAR_DAYS * 2] = { 0 };
+    for(int first = 0; first < HOLIDAY_TABLE_DAYS; first += CALENDAR_DAYS){
+        int count = HOLIDAY_TABLE_DAYS - first < CALENDAR_DAYS ? HOLIDAY_TABLE_DAYS - first : CALENDAR_DAYS;
+        uint8_t header[7] = { 1, FULL | (first + count >= HOLIDAY_TABLE_DAYS ? LAST : 0),
+                              YEAR & 0xff, YEAR >> 8, first & 0xff, first >> 8, count };
+        memcpy(chunk, header, sizeof(header));
+        DictionaryIterator *message = host_inbox_begin();
+        dict_write_data(message, KEY_CALENDAR, chunk, 7 + count * 2);
+        host_inbox_deliver();
+        host_idle();
+    }
+}
+
+/** One chunk of records from the first on, returns its length **/
+static size_t birthday_chunk(uint8_t *chunk, uint8_t flags, int first, int records){
+    size_t length = 3;
+    chunk[0] = 1;
+    chunk[1] = flags;
+    chunk[2] = records;
+    for(int i = first; i < first + records; i++){
+        chunk[length++] = 1 + i % 12;
+        chunk[length++] = 1 + i % 28;
+        chunk[length++] = NAME_LEN;
+        memcpy(&chunk[length], NAME, NAME_LEN);
+        length += NAME_LEN;
+    }
+    return length;
+}
+
+static void send_chunk(const uint8_t *chunk, size_t length){
+    DictionaryIterator *message = host_inbox_begin();
+    dict_write_data(message, KEY_BIRTHDAY_DATA, chunk, length);
+    host_inbox_deliver();
+    host_idle();
+}
+
+/** A list of count birthdays with NAME_LEN byte names, spread over the year **/
+static void send_birthdays(int count){
+    uint8_t chunk[BIRTHDAY_MESSAGE_MAX];
+    int per_chunk = (BIRTHDAY_MESSAGE_MAX - 3) / (3 + NAME_LEN);
+    int sent = 0;
+    do {
+        int records = count - sent < per_chunk ? count - sent : per_chunk;
+        uint8_t flags = (sent == 0 ? FULL : 0) | (sent + records >= count ? LAST : 0);
+        send_chunk(chunk, birthday_chunk(chunk, flags, sent, records));
+        sent += records;
+    } while(sent < count);
+}
+
+void host_run(void){
+    host_checks_begin("test_birthdays");
+
+    // Days that don't exist
+    birthdays_clear();
+    host_expect(birthdays_add(2, 29, NAME, NAME_LEN), "Feb 29 was refused");
+    host_expect(!birthdays_add(2, 30, NAME, NAME_LEN), "Feb 30 was taken");
+    host_expect(!birthdays_add(4, 31, NAME, NAME_LEN), "Apr 31 was taken");
+    host_expect(!birthdays_add(13, 1, NAME, NAME_LEN), "month 13 was taken");
+    host_expect(birthdays_count() == 1, "refused days were added");
+
+    // Everything the face persists at its largest
+    DictionaryIterator *weather = host_inbox_begin();
+    dict_write_int32(weather, KEY_TEMPERATURE, 20);
+    host_inbox_deliver();
+    host_idle();
+    send_calendar();
+    host_expect(holidays_from_phone(), "the calendar wasn't stored");
+    host_reset_counters();
+    send_birthdays(BIRTHDAY_MAX);
+    HostCounters counters;
+    host_get_counters(&counters);
+    host_expect(birthdays_count() == BIRTHDAY_MAX, "the full list wasn't indexed");
+    host_expect(counters.persist_failures == 0, "the full index didn't fit the persist quota");
+    host_expect(birthdays_load() && birthdays_count() == BIRTHDAY_MAX, "the full index didn't load back");
+    printf("test_birthdays: %u of %d persist bytes used\n", (unsigned)host_persist_used(), HOST_PERSIST_QUOTA);
+
+    // A shorter list leaves no keys behind
+    send_birthdays(1);
+    host_expect(!persist_exists(KEY_BDAY_ENTRIES + 1), "entry keys of the longer list were left");
+    host_expect(!persist_exists(KEY_BDAY_NAMES + 1), "name keys of the longer list were left");
+    host_expect(birthdays_load() && birthdays_count() == 1, "the short index didn't load back");
+
+    // A transfer that stops after its first chunk leaves the list alone
+    uint8_t chunk[BIRTHDAY_MESSAGE_MAX];
+    send_chunk(chunk, birthday_chunk(chunk, FULL, 1, 3));
+    host_expect(birthdays_count() == 1 && birthdays_find(1, 1) != NULL, "an unfinished transfer changed the list");
+
+    // So does a last chunk short of the records it announced
+    size_t length = birthday_chunk(chunk, FULL | LAST, 1, 3);
+    send_chunk(chunk, length - (3 + NAME_LEN));
+    host_expect(birthdays_count() == 1 && birthdays_find(1, 1) != NULL, "a truncated transfer changed the list");
+
+    // A whole one after them still applies
+    send_birthdays(3);
+    host_expect(birthdays_count() == 3 && birthdays_find(3, 3) != NULL, "a transfer after a dropped one wasn't applied");
+}
@@ -0,0 +1,79 @@
+#include "host.h"
+#include "holidays.h"
+#include "calendar.h"
+
+/*
+ * Plays the phone's side of the calendar sync against the face. Chunks
+ * the watch can't apply must not touch the stored table and must make it
+ * ask for a whole one, so the phone doesn't go on believing it was sent.
+ */
+
+#define YEAR 2025
+#define CHUNK_DAYS 96
+#define FULL 0x01
+#define LAST 0x02
+#define KEY_CALENDAR_HEADER 70
+
+/** Every day of the chunk shows the same image **/
+static void send_chunk(int year, uint8_t flags, int first, int count, uint8_t image){
+    uint8_t chunk[7 + CHUNK_DAYS * 2] = { 1, flags, year & 0xff, year >> 8, first & 0xff, first >> 8, count };
+    for(int i = 0; i < count; i++){
+        chunk[7 + i * 2] = image;
+        chunk[8 + i * 2] = BANNER_NONE;
+    }
+    DictionaryIterator *message = host_inbox_begin();
+    dict_write_data(message, KEY_CALENDAR, chunk, 7 + count * 2);
+    host_inbox_deliver();
+    host_idle();
+}
+
+static void send_table(int year, uint8_t image){
+    for(int first = 0; first < HOLIDAY_TABLE_DAYS; first += CHUNK_DAYS){
+        int count = HOLIDAY_TABLE_DAYS - first < CHUNK_DAYS ? HOLIDAY_TABLE_DAYS - first : CHUNK_DAYS;
+        send_chunk(year, FULL | (first + count >= HOLIDAY_TABLE_DAYS ? LAST : 0), first, count, image);
+    }
+}
+
+/** Year of each resync the watch asked for since the last call, 0 if none **/
+static int resyncs(int *count){
+    DictionaryIterator sent;
+    int year = 0;
+    *count = 0;
+    while(host_outbox_pop(&sent)){
+        Tuple *resync = dict_find(&sent, KEY_CALENDAR_RESYNC);
+        if(resync != NULL){
+            year = resync->value->uint16;
+            (*count)++;
+        }
+    }
+    return year;
+}
+
+void host_run(void){
+    host_checks_begin("test_calendar");
+    int count;
+    resyncs(&count);
+
+    // A delta with no table from the phone to patch
+    send_chunk(YEAR, 0, 10, 3, HOLIDAY_IMAGE_BIRTHDAY);
+    send_chunk(YEAR, 0, 20, 3, HOLIDAY_IMAGE_BIRTHDAY);
+    host_expect(resyncs(&count) == YEAR && count == 1, "a dropped delta didn't ask for the year once");
+    host_expect(holidays_lookup(10).image != HOLIDAY_IMAGE_BIRTHDAY, "a delta patched the built-in table");
+
+    // The whole year, then a delta on top of it
+    send_table(YEAR, HOLIDAY_IMAGE_SUNDAY);
+    host_expect(holidays_from_phone() && holidays_lookup(200).image == HOLIDAY_IMAGE_SUNDAY, "the full table wasn't loaded");
+    send_chunk(YEAR, 0, 10, 3, HOLIDAY_IMAGE_BIRTHDAY);
+    host_expect(holidays_lookup(11).image == HOLIDAY_IMAGE_BIRTHDAY, "the delta wasn't applied");
+    host_expect(resyncs(&count) == 0, "an applied table asked for a resync");
+
+    // Next year's table while this one is on screen
+    uint8_t before[4], after[4];
+    persist_read_data(KEY_CALENDAR_HEADER, before, sizeof(before));
+    send_table(YEAR + 1, HOLIDAY_IMAGE_MONDAY);
+    persist_read_data(KEY_CALENDAR_HEADER, after, sizeof(after));
+    host_expect(memcmp(before, after, sizeof(before)) == 0, "another year's table replaced the stored one");
+    host_expect(holidays_year() == YEAR && holidays_lookup(200).image == HOLIDAY_IMAGE_SUNDAY,
+           "another year's table replaced the one on screen");
+    host_expect(resyncs(&count) == YEAR && count == 1, "another year's table didn't ask for this year once");
+}
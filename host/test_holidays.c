@@ -0,0 +1,311 @@
+#include "host.h"
+#include "holidays.h"
+#include "string_table.h"
+
+/*
+ * Compiles every year from 2000 to 2040 with src/holidays.c and compares
+ * each day with what the face did before the rule table, the switch in
+ * get_background_resource() copied below. Days may only differ where the
+ * rules meant to change them: Easter, Thanksgiving and the seasons move
+ * with the calendar now, April and November are no longer one holiday
+ * each, and Thursdays have their own image. Anything else fails.
+ *
+ * Easter is checked against Gauss' algorithm, the seasons against the
+ * days they can fall on and a few years' published dates.
+ */
+
+#define FIRST_YEAR 2000
+#define LAST_YEAR 2040
+
+// Stands in for a Thursday quote, the old and the new code pick theirs at random
+#define THOUGHT "<thought>"
+
+typedef struct {
+    uint32_t resource;
+    const char *banner;
+} Day;
+
+static int s_failures;
+
+static void fail(int year, int month, int day, const char *format, const char *detail){
+    if(++s_failures <= 20){
+        fprintf(stderr, "%04d-%02d-%02d: ", year, month, day);
+        fprintf(stderr, format, detail);
+        fputc('\n', stderr);
+    }
+}
+
+/** The weekday branch of the face before the rule table **/
+static Day baseline_weekday(int weekday){
+    switch(weekday){
+        case 0: return (Day){ RESOURCE_ID_IMAGE_SUNDAY, NULL };
+        case 1: return (Day){ RESOURCE_ID_IMAGE_MONDAY, NULL };
+        case 2: return (Day){ RESOURCE_ID_IMAGE_TUESDAY, NULL };
+        case 3: return (Day){ RESOURCE_ID_IMAGE_CAMEL, NULL };
+        case 4: return (Day){ 0, THOUGHT };
+        case 5: return (Day){ RESOURCE_ID_IMAGE_FRIDAY, NULL };
+        case 6: return (Day){ RESOURCE_ID_IMAGE_SATURDAY, NULL };
+        default: return (Day){ 0, NULL };
+    }
+}
+
+/** get_background_resource() before the rule table, without birthdays **/
+static Day baseline_day(int month, int day, int weekday){
+    switch(month){
+        case 1:
+            if(day == 1) return (Day){ RESOURCE_ID_IMAGE_NEW_YEARS, "Happy New Year!" };
+            break;
+        case 2:
+            if(day == 14) return (Day){ RESOURCE_ID_IMAGE_VALENTINE, "Valentine's Day!" };
+            break;
+        case 3:
+            if(day == 17) return (Day){ RESOURCE_ID_IMAGE_ST_PATRICK, "St. Patrick's Day!" };
+            if(day == 20 || day == 21) return (Day){ RESOURCE_ID_IMAGE_SPRING, "Happy Spring!" };
+            break;
+        case 4:
+            if(day == 1) return (Day){ RESOURCE_ID_IMAGE_APRIL_FOOLS, "April Fools!" };
+            return (Day){ RESOURCE_ID_IMAGE_RABBIT, NULL };
+        case 5:
+            if(day == 5) return (Day){ RESOURCE_ID_IMAGE_CINCO_DE_MAYO, "Happy Cinco de Mayo!" };
+            break;
+        case 6:
+            if(day == 22 || day == 23) return (Day){ RESOURCE_ID_IMAGE_SUMMER, "Happy Summer!" };
+            break;
+        case 7:
+            if(day == 4) return (Day){ RESOURCE_ID_IMAGE_FOURTH_OF_JULY, "Happy 4th of July!" };
+            break;
+        case 9:
+            if(day == 22 || day == 23) return (Day){ RESOURCE_ID_IMAGE_FALL, "Happy Fall!" };
+            break;
+        case 10:
+            if(day >= 25 && day <= 30) return (Day){ RESOURCE_ID_IMAGE_10_31, NULL };
+            if(day == 31) return (Day){ RESOURCE_ID_IMAGE_10_31, "Happy Halloween!" };
+            break;
+        case 11:
+            return (Day){ RESOURCE_ID_IMAGE_TURKEY, NULL };
+        case 12:
+            // The 22nd fell through to the image of the 18th-21st with its banner set
+            if(day == 22) return (Day){ RESOURCE_ID_IMAGE_WINTER, "Happy Winter!" };
+            if(day >= 18 && day <= 21) return (Day){ RESOURCE_ID_IMAGE_WINTER, NULL };
+            if(day == 25) return (Day){ RESOURCE_ID_IMAGE_12_25, "Merry Christmas!" };
+            if(day >= 23) return (Day){ RESOURCE_ID_IMAGE_12_25, NULL };
+            break;
+    }
+    return baseline_weekday(weekday);
+}
+
+static Day compiled_day(int yday){
+    HolidayDay entry = holidays_lookup(yday);
+    const char *banner = NULL;
+    if(entry.banner == BANNER_THURSDAY_THOUGHTS)
+        banner = THOUGHT;
+    else if(entry.banner != BANNER_NONE)
+        banner = holidays_banner_text(entry.banner);
+    return (Day){ holidays_image_resource(entry.image), banner };
+}
+
+static bool same_banner(const char *a, const char *b){
+    return (a == NULL && b == NULL) || (a != NULL && b != NULL && strcmp(a, b) == 0);
+}
+
+static bool same_day(Day a, Day b){
+    return a.resource == b.resource && same_banner(a.banner, b.banner);
+}
+
+/** Easter Sunday by Gauss, valid 1900-2099, as day of the year **/
+static int gauss_easter(int year, int *month, int *day){
+    int a = year % 19, b = year % 4, c = year % 7;
+    int d = (19 * a + 24) % 30;
+    int e = (2 * b + 4 * c + 6 * d + 5) % 7;
+    if(22 + d + e <= 31){
+        *month = 3;
+        *day = 22 + d + e;
+    }else{
+        *month = 4;
+        *day = d + e - 9;
+        if(*day == 26)
+            *day = 19;
+        else if(*day == 25 && d == 28 && e == 6 && a > 10)
+            *day = 18;
+    }
+    struct tm date = { .tm_year = year - 1900, .tm_mon = *month - 1, .tm_mday = *day, .tm_hour = 12 };
+    mktime(&date);
+    return date.tm_yday;
+}
+
+/** Day of the year the compiled table puts a banner on, -1 if none or more than one **/
+static int banner_yday(int days, uint8_t banner){
+    int found = -1;
+    for(int yday = 0; yday < days; yday++){
+        if(holidays_lookup(yday).banner != banner)
+            continue;
+        if(found >= 0)
+            return -1;
+        found = yday;
+    }
+    return found;
+}
+
+/** Each season has to land inside the days it can fall on (UTC) **/
+static const struct {
+    uint8_t banner;
+    int month;
+    int earliest;
+    int latest;
+} s_seasons[] = {
+    { BANNER_SPRING, 3, 19, 21 },
+    { BANNER_SUMMER, 6, 20, 22 },
+    { BANNER_FALL,   9, 21, 24 },
+    { BANNER_WINTER, 12, 20, 23 },
+};
+
+/** Published equinoxes and solstices (UTC), month and day of each season **/
+static const struct {
+    int year;
+    int days[4];
+} s_published[] = {
+    { 2000, { 20, 21, 22, 21 } },
+    { 2020, { 20, 20, 22, 21 } },
+    { 2023, { 20, 21, 23, 22 } },
+    { 2024, { 20, 20, 22, 21 } },
+    { 2025, { 20, 21, 22, 21 } },
+};
+
+static bool is_weekday_fallback(Day day, int weekday){
+    Day fallback = baseline_weekday(weekday);
+    if(weekday == 4)
+        fallback.resource = RESOURCE_ID_IMAGE_THURSDAY;
+    return same_day(day, fallback);
+}
+
+/** Whether a day the new table changed is one of the changes the rules were written to make **/
+static const char *explain(Day old, Day now, int yday, int weekday, int easter, int thanksgiving,
+                           const int seasons[4]){
+    // Thursdays have an image under the quote now
+    if(old.resource == 0 && same_banner(old.banner, THOUGHT) &&
+       now.resource == RESOURCE_ID_IMAGE_THURSDAY && same_banner(now.banner, THOUGHT))
+        return "thursday";
+
+    // The week up to Easter, wherever it falls, the banner on the day
+    if(yday >= easter - 6 && yday <= easter && now.resource == RESOURCE_ID_IMAGE_RABBIT &&
+       same_banner(now.banner, yday == easter ? "Happy Easter!" : NULL))
+        return "easter";
+
+    // Thanksgiving week, the banner on the 4th Thursday, running into December some years
+    if(yday >= thanksgiving - 3 && yday <= thanksgiving + 3 && now.resource == RESOURCE_ID_IMAGE_TURKEY &&
+       same_banner(now.banner, yday == thanksgiving ? "Happy Thanksgiving!" : NULL))
+        return "thanksgiving";
+
+    // Seasons on their astronomical day, winter with the four days before it
+    if((now.resource == RESOURCE_ID_IMAGE_SPRING && yday == seasons[0] && same_banner(now.banner, "Happy Spring!")) ||
+       (now.resource == RESOURCE_ID_IMAGE_SUMMER && yday == seasons[1] && same_banner(now.banner, "Happy Summer!")) ||
+       (now.resource == RESOURCE_ID_IMAGE_FALL && yday == seasons[2] && same_banner(now.banner, "Happy Fall!")) ||
+       (now.resource == RESOURCE_ID_IMAGE_WINTER && yday >= seasons[3] - 4 && yday <= seasons[3] &&
+        same_banner(now.banner, yday == seasons[3] ? "Happy Winter!" : NULL)))
+        return "season";
+
+    // What the old fixed ranges covered and the rules don't goes back to the weekday
+    if(is_weekday_fallback(now, weekday) && old.banner == NULL &&
+       (old.resource == RESOURCE_ID_IMAGE_RABBIT || old.resource == RESOURCE_ID_IMAGE_TURKEY ||
+        old.resource == RESOURCE_ID_IMAGE_WINTER))
+        return "range";
+    if(is_weekday_fallback(now, weekday) &&
+       ((old.resource == RESOURCE_ID_IMAGE_SPRING && yday != seasons[0]) ||
+        (old.resource == RESOURCE_ID_IMAGE_SUMMER && yday != seasons[1]) ||
+        (old.resource == RESOURCE_ID_IMAGE_FALL && yday != seasons[2]) ||
+        (old.resource == RESOURCE_ID_IMAGE_WINTER && yday != seasons[3])))
+        return "season";
+    return NULL;
+}
+
+static void check_year(int year, uint32_t *changed){
+    holidays_compile(year);
+    int days = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0) ? 366 : 365;
+
+    int easter_month, easter_day;
+    int easter = gauss_easter(year, &easter_month, &easter_day);
+    // A single day holiday on Easter Sunday keeps its banner
+    int easter_banner = banner_yday(days, BANNER_EASTER);
+    if(easter_banner != easter && !(easter_banner < 0 && baseline_day(easter_month, easter_day, 0).banner != NULL))
+        fail(year, easter_month, easter_day, "Easter %s", "isn't on Gauss' date");
+
+    struct tm november = { .tm_year = year - 1900, .tm_mon = 10, .tm_mday = 1, .tm_hour = 12 };
+    mktime(&november);
+    int thanksgiving = november.tm_yday + (4 - november.tm_wday + 7) % 7 + 21;
+
+    int seasons[4];
+    for(int s = 0; s < 4; s++){
+        seasons[s] = banner_yday(days, s_seasons[s].banner);
+        struct tm bound = { .tm_year = year - 1900, .tm_mon = s_seasons[s].month - 1, .tm_hour = 12 };
+        bound.tm_mday = s_seasons[s].earliest;
+        mktime(&bound);
+        int earliest = bound.tm_yday;
+        if(seasons[s] < earliest || seasons[s] > earliest + s_seasons[s].latest - s_seasons[s].earliest)
+            fail(year, s_seasons[s].month, s_seasons[s].earliest, "%s season outside the days it can fall on",
+                 holidays_banner_text(s_seasons[s].banner));
+    }
+    for(unsigned int p = 0; p < ARRAY_LENGTH(s_published); p++){
+        if(s_published[p].year != year)
+            continue;
+        for(int s = 0; s < 4; s++){
+            struct tm date = { .tm_year = year - 1900, .tm_mon = s_seasons[s].month - 1,
+                               .tm_mday = s_published[p].days[s], .tm_hour = 12 };
+            mktime(&date);
+            if(seasons[s] != date.tm_yday)
+                fail(year, s_seasons[s].month, s_published[p].days[s], "%s not on the published day",
+                     holidays_banner_text(s_seasons[s].banner));
+        }
+    }
+
+    for(int yday = 0; yday < days; yday++){
+        struct tm date = { .tm_year = year - 1900, .tm_mday = 1 + yday, .tm_hour = 12 };
+        mktime(&date);
+        int month = date.tm_mon + 1;
+        Day old = baseline_day(month, date.tm_mday, date.tm_wday);
+        Day now = compiled_day(yday);
+        if(same_day(old, now))
+            continue;
+
+        (*changed)++;
+        if(explain(old, now, yday, date.tm_wday, easter, thanksgiving, seasons) == NULL){
+            char detail[96];
+            snprintf(detail, sizeof(detail), "resource %u \"%s\" was %u \"%s\"", (unsigned)now.resource,
+                     now.banner ? now.banner : "", (unsigned)old.resource, old.banner ? old.banner : "");
+            fail(year, month, date.tm_mday, "unexplained change, %s", detail);
+        }
+    }
+
+    // The rules have to cover their whole range, not only the days that changed
+    for(int yday = easter - 6; yday <= easter; yday++){
+        Day now = compiled_day(yday);
+        struct tm date = { .tm_year = year - 1900, .tm_mday = 1 + yday, .tm_hour = 12 };
+        mktime(&date);
+        Day old = baseline_day(date.tm_mon + 1, date.tm_mday, date.tm_wday);
+        // Single day holidays and the spring equinox come first
+        if(old.banner != NULL && old.resource != RESOURCE_ID_IMAGE_SPRING && same_day(old, now))
+            continue;
+        if(yday == seasons[0])
+            continue;
+        if(now.resource != RESOURCE_ID_IMAGE_RABBIT)
+            fail(year, date.tm_mon + 1, date.tm_mday, "%s", "Easter week missing the rabbit");
+    }
+    for(int yday = thanksgiving - 3; yday <= thanksgiving + 3; yday++){
+        struct tm date = { .tm_year = year - 1900, .tm_mday = 1 + yday, .tm_hour = 12 };
+        mktime(&date);
+        if(compiled_day(yday).resource != RESOURCE_ID_IMAGE_TURKEY)
+            fail(year, date.tm_mon + 1, date.tm_mday, "%s", "Thanksgiving week missing the turkey");
+    }
+}
+
+int main(void){
+    string_table_init();
+    uint32_t changed = 0, days = 0;
+    for(int year = FIRST_YEAR; year <= LAST_YEAR; year++){
+        check_year(year, &changed);
+        days += year % 4 == 0 && (year % 100 != 0 || year % 400 == 0) ? 366 : 365;
+    }
+
+    printf("test_holidays: %d-%d, %u days, %u changed by the rules, %d failures\n",
+           FIRST_YEAR, LAST_YEAR, days, changed, s_failures);
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#include "host.h"
+#include "holidays.h"
+#include "calendar.h"
+
+/*
+ * Runs the face across New Year's Eve. Tomorrow's background is loaded
+ * at 23:55, which on Dec 31 needs next year's holiday table; the face
+ * has to keep today's table loaded until midnight all the same, then
+ * switch and show New Year's Day from the prefetched bitmap. The phone's
+ * last table is the year before's, so launch asks for this year's; the
+ * look ahead mustn't ask for next year's, midnight asks for it once.
+ */
+
+// 2025-12-31 23:40 UTC
+#define NEW_YEARS_EVE 1767224400
+#define DEC_31 364
+#define KEY_CALENDAR_HEADER 70
+#define KEY_TEMPERATURE 0
+
+__attribute__((constructor)) static void new_year_start(void){
+    if(getenv("HOST_START") == NULL)
+        host_set_time(NEW_YEARS_EVE);
+    // A complete 2024 table, see CalendarHeader
+    const uint8_t header[] = { 1, true, 2024 & 0xff, 2024 >> 8 };
+    persist_write_data(KEY_CALENDAR_HEADER, header, sizeof(header));
+}
+
+/** Resyncs the watch sent since the last call, the year of the last in year **/
+static int resyncs(int *year){
+    DictionaryIterator sent;
+    int count = 0;
+    while(host_outbox_pop(&sent)){
+        Tuple *resync = dict_find(&sent, KEY_CALENDAR_RESYNC);
+        if(resync != NULL){
+            *year = resync->value->uint16;
+            count++;
+        }
+    }
+    return count;
+}
+
+void host_run(void){
+    host_checks_begin("test_new_year");
+    // The phone stays connected for the calendar
+    host_expect(holidays_year() == 2025, "2025 isn't loaded on Dec 31");
+    int year = 0;
+    host_expect(resyncs(&year) == 1 && year == 2025, "launch didn't ask for 2025 once");
+
+    // Past the prefetch
+    host_reset_counters();
+    host_advance(18 * SECONDS_PER_MINUTE);
+    host_expect(host_calls("gbitmap_create_with_resource") == 1, "Jan 1 wasn't prefetched at 23:55");
+    host_expect(holidays_year() == 2025, "the prefetch left 2026 loaded on Dec 31");
+    host_expect(holidays_lookup(DEC_31).image == HOLIDAY_IMAGE_CHRISTMAS, "Dec 31 lost the Christmas week");
+    // Any message from the phone lets the watch send a resync it owes
+    DictionaryIterator *weather = host_inbox_begin();
+    dict_write_int32(weather, KEY_TEMPERATURE, 20);
+    host_inbox_deliver();
+    host_idle();
+    host_expect(resyncs(&year) == 0, "the prefetch asked the phone for 2026");
+
+    // Past midnight
+    host_reset_counters();
+    host_advance(4 * SECONDS_PER_MINUTE);
+    host_expect(holidays_year() == 2026, "2026 isn't loaded after midnight");
+    host_expect(holidays_lookup(0).banner == BANNER_NEW_YEAR, "Jan 1 has no New Year banner");
+    host_expect(host_calls("gbitmap_create_with_resource") == 0, "midnight loaded a bitmap the prefetch had");
+    host_expect(resyncs(&year) == 1 && year == 2026, "midnight didn't ask for 2026 once");
+}
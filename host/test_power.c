@@ -0,0 +1,96 @@
+#include "host.h"
+#include "power.h"
+#include "messages.h"
+
+/*
+ * Runs a day of the face in each power tier and checks each tier costs
+ * less than the one before it: fewer weather requests in saver, fewer
+ * draws and no background swap in critical, no vibration on disconnect
+ * below normal, and no persist writes for readings that didn't change.
+ * Then moves the saver threshold from the config and checks the face
+ * follows it straight away.
+ */
+
+#define KEY_TEMPERATURE 0
+#define DAY_MINUTES (24 * 60)
+
+typedef struct {
+    uint32_t requests;
+    uint32_t draws;
+    uint32_t bitmaps;
+    uint32_t vibes;
+    uint32_t writes;
+} DayCost;
+
+/** Answer weather requests, returns how many there were **/
+static uint32_t answer_phone(void){
+    DictionaryIterator sent;
+    uint32_t requests = 0;
+    while(host_outbox_pop(&sent)){
+        if(dict_find(&sent, KEY_TEMPERATURE) == NULL)
+            continue;
+        DictionaryIterator *reply = host_inbox_begin();
+        dict_write_int32(reply, KEY_TEMPERATURE, 20);
+        host_inbox_deliver();
+        requests++;
+    }
+    return requests;
+}
+
+/** A day at a charge, with the phone dropping out once at noon **/
+static DayCost run_day(uint8_t charge, const char *name){
+    DayCost cost = { 0 };
+    host_set_battery(charge, false);
+    host_idle();
+    answer_phone();
+    host_reset_counters();
+    for(int minute = 0; minute < DAY_MINUTES; minute++){
+        if(minute == 12 * 60)
+            host_set_connected(false);
+        if(minute == 12 * 60 + 5)
+            host_set_connected(true);
+        host_advance(SECONDS_PER_MINUTE);
+        cost.requests += answer_phone();
+        host_idle();
+    }
+    HostCounters counters;
+    host_get_counters(&counters);
+    cost.draws = counters.draws;
+    cost.bitmaps = host_calls("gbitmap_create_with_resource");
+    cost.vibes = host_calls("vibes_double_pulse");
+    cost.writes = counters.persist_writes;
+    printf("test_power: %-8s %3d%%  %3u weather requests, %5u draws, %u bitmaps, %u vibrations, %u persist writes\n",
+        name, charge, cost.requests, cost.draws, cost.bitmaps, cost.vibes, cost.writes);
+    return cost;
+}
+
+void host_run(void){
+    host_checks_begin("test_power");
+
+    DayCost normal = run_day(80, "normal");
+    host_expect(power_tier() == POWER_NORMAL, "80% isn't normal");
+    DayCost saver = run_day(25, "saver");
+    host_expect(power_tier() == POWER_SAVER, "25% isn't saver");
+    DayCost critical = run_day(5, "critical");
+    host_expect(power_tier() == POWER_CRITICAL, "5% isn't critical");
+
+    host_expect(normal.vibes == 1 && saver.vibes == 0 && critical.vibes == 0, "vibrated on disconnect below normal");
+    host_expect(saver.requests < normal.requests, "saver didn't ask for the weather less");
+    host_expect(critical.requests < saver.requests, "critical didn't ask for the weather less");
+    host_expect(critical.draws < saver.draws, "critical didn't draw less");
+    host_expect(normal.bitmaps > 0 && critical.bitmaps == 0, "critical swapped the background");
+    // The first day stores the first reading, after that the temperature never changes
+    host_expect(saver.writes == 0 && critical.writes == 0, "a day of the same temperature wrote to persist");
+
+    // Charging past the hysteresis, then saver from 90% down as set on the phone
+    host_set_battery(80, true);
+    host_expect(power_tier() == POWER_NORMAL, "charging to 80% didn't leave the low tiers");
+    host_set_battery(80, false);
+    DictionaryIterator *config = host_inbox_begin();
+    dict_write_int32(config, KEY_POWER_SAVER, 90);
+    host_inbox_deliver();
+    host_idle();
+    host_expect(power_tier() == POWER_SAVER, "a saver threshold of 90% left 80% normal");
+    DayCost configured = run_day(80, "90% set");
+    host_expect(configured.requests < normal.requests, "the configured saver tier didn't ask for the weather less");
+}
@@ -0,0 +1,79 @@
+#include "host.h"
+#include "settings.h"
+
+/*
+ * Launches the face twice on one persist file, see the check target.
+ * The first launch finds settings and birthdays under the keys older
+ * releases used and has to move them into the blob and the index; the
+ * second finds the blob. Both have to get to the first frame setting
+ * each text layer once and loading one background.
+ */
+
+// Keys older releases persisted each setting under
+#define LEGACY_KEY_TWENTY_FOUR_HOUR_FORMAT 1
+#define LEGACY_KEY_BATTERY_ON_OFF 2
+#define LEGACY_KEY_TEMP_TYPE 3
+#define LEGACY_KEY_BIRTHDAY_LIST 4
+#define LEGACY_KEY_INVERT_COLOR 5
+#define LEGACY_KEY_WEATHER_INTERVAL 7
+#define LEGACY_KEY_BDAY_LIST_SIZE 20
+#define LEGACY_BIRTHDAYS "Ann,03/14,Bob,07/02,Cleo,12/25"
+#define KEY_SETTINGS 10
+#define KEY_BDAY_HEADER 30
+
+static const uint32_t s_legacy_keys[] = {
+    LEGACY_KEY_TWENTY_FOUR_HOUR_FORMAT, LEGACY_KEY_BATTERY_ON_OFF, LEGACY_KEY_TEMP_TYPE,
+    LEGACY_KEY_BIRTHDAY_LIST, LEGACY_KEY_INVERT_COLOR, LEGACY_KEY_WEATHER_INTERVAL, LEGACY_KEY_BDAY_LIST_SIZE,
+};
+
+static bool s_migrating;
+static uint64_t s_started;
+/** Seed what an older release left behind, unless an earlier launch already moved it **/
+__attribute__((constructor)) static void startup_seed(void){
+    s_migrating = !persist_exists(KEY_SETTINGS);
+    if(s_migrating){
+        persist_write_bool(LEGACY_KEY_TWENTY_FOUR_HOUR_FORMAT, true);
+        persist_write_bool(LEGACY_KEY_BATTERY_ON_OFF, true);
+        persist_write_string(LEGACY_KEY_TEMP_TYPE, "Celsius");
+        persist_write_bool(LEGACY_KEY_INVERT_COLOR, true);
+        persist_write_int(LEGACY_KEY_WEATHER_INTERVAL, 60);
+        persist_write_string(LEGACY_KEY_BIRTHDAY_LIST, LEGACY_BIRTHDAYS);
+        persist_write_int(LEGACY_KEY_BDAY_LIST_SIZE, sizeof(LEGACY_BIRTHDAYS));
+    }
+    host_reset_counters();
+    s_started = host_now_ns();
+}
+
+void host_run(void){
+    uint64_t elapsed = host_now_ns() - s_started;
+    HostCounters init;
+    host_get_counters(&init);
+    uint32_t texts = host_calls("text_layer_set_text");
+    uint32_t bitmaps = host_calls("gbitmap_create_with_resource");
+    // The first frame
+    host_idle();
+    HostCounters frame;
+    host_get_counters(&frame);
+
+    host_checks_begin("test_startup");
+    printf("test_startup: %s launch %.3f ms, %u persist reads, %u writes, %u text sets, %u bitmaps, %u draws\n",
+        s_migrating ? "migrating" : "settled", elapsed / 1e6, init.persist_reads, init.persist_writes,
+        texts, bitmaps, frame.draws);
+
+    // The background and the Bluetooth icon
+    host_expect(bitmaps == 2, "startup loaded more than one background");
+    host_expect(texts <= host_calls("text_layer_create"), "startup set a text layer more than once");
+
+    if(s_migrating){
+        for(size_t i = 0; i < ARRAY_LENGTH(s_legacy_keys); i++)
+            host_expect(!persist_exists(s_legacy_keys[i]), "a legacy key was left after migrating");
+        host_expect(persist_exists(KEY_BDAY_HEADER), "the birthday list wasn't moved into the index");
+    }else{
+        host_expect(init.persist_writes == 0, "a settled launch wrote to persist");
+    }
+    Settings settings;
+    settings_load(&settings);
+    host_expect(settings.twenty_four_hour && settings.battery_on && settings.inverted, "a switch was lost");
+    host_expect(settings.temp_format == TEMP_CELSIUS, "the temperature format was lost");
+    host_expect(settings.weather_interval == 60, "the weather interval was lost");
+}
@@ -0,0 +1,311 @@
+#include <pebble.h>
+#include "birthdays.h"
+#include "profile.h"
+#include "journal.h"
+
+// Persist keys 30-59 belong to the birthday index
+#define KEY_BDAY_HEADER 30
+#define KEY_BDAY_ENTRIES 31
+#define KEY_BDAY_NAMES 40
+#define KEY_BDAY_END 60
+
+#define BIRTHDAY_INDEX_VERSION 1
+
+// Binary list sent by the phone
+#define BIRTHDAY_FORMAT_VERSION 1
+#define BIRTHDAY_CHUNK_FIRST 0x01
+#define BIRTHDAY_CHUNK_LAST 0x02
+#define BIRTHDAY_CHUNK_HEADER 3
+#define BIRTHDAY_RECORD_HEADER 3
+
+typedef struct {
+    uint16_t day;   // day of a leap year, so Feb 29 has its own slot
+    uint16_t name;  // offset into the name pool
+} BirthdayEntry;
+
+typedef struct {
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t count;
+    uint16_t pool_used;
+} BirthdayHeader;
+
+typedef struct {
+    BirthdayEntry entries[BIRTHDAY_MAX];
+    char pool[BIRTHDAY_POOL_SIZE];
+    uint16_t count;
+    uint16_t pool_used;
+} BirthdayIndex;
+
+#if BIRTHDAY_MAX * 4 + BIRTHDAY_POOL_SIZE + 6 > BIRTHDAY_PERSIST_BUDGET
+#error "The birthday index doesn't fit its share of persist storage"
+#endif
+
+// A list from the phone is decoded into the staging index and swapped in
+// whole with its last chunk, so a transfer that stops halfway changes nothing
+static BirthdayIndex s_indexes[2];
+static BirthdayIndex *s_index = &s_indexes[0];
+static BirthdayIndex *s_staging = &s_indexes[1];
+static bool s_receiving;
+// Records the chunks of the transfer announced and the ones that decoded
+static uint16_t s_announced;
+static uint16_t s_decoded;
+static BirthdayHeader s_header;
+
+/** Day of a leap year (0 based) for a month (1-12) and day **/
+static uint16_t birthday_day(int month, int day){
+    static const uint16_t month_start[] = { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335 };
+    return month_start[month - 1] + day - 1;
+}
+
+/**
+ * Write a buffer across as many persist keys as it needs, deleting the keys
+ * up to end a longer buffer used before. False if a write failed.
+ **/
+static bool persist_write_chunked(uint32_t key, uint32_t end, const void *data, size_t size){
+    const uint8_t *bytes = data;
+    bool written = true;
+    for(size_t offset = 0; offset < size; offset += PERSIST_DATA_MAX_LENGTH, key++){
+        size_t length = size - offset;
+        if(length > PERSIST_DATA_MAX_LENGTH)
+            length = PERSIST_DATA_MAX_LENGTH;
+        written &= journal_write(key, bytes + offset, length);
+    }
+    for(; key < end; key++){
+        if(persist_exists(key))
+            persist_delete(key);
+    }
+    return written;
+}
+
+/** Read a buffer written by persist_write_chunked() **/
+static bool persist_read_chunked(uint32_t key, void *data, size_t size){
+    uint8_t *bytes = data;
+    for(size_t offset = 0; offset < size; offset += PERSIST_DATA_MAX_LENGTH, key++){
+        size_t length = size - offset;
+        if(length > PERSIST_DATA_MAX_LENGTH)
+            length = PERSIST_DATA_MAX_LENGTH;
+        PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+        if(persist_read_data(key, bytes + offset, length) != (int)length)
+            return false;
+    }
+    return true;
+}
+
+static void index_clear(BirthdayIndex *index){
+    index->count = 0;
+    index->pool_used = 0;
+}
+
+static bool index_add(BirthdayIndex *index, int month, int day, const char *name, size_t name_len){
+    // Feb 29 is a valid birthday, it only comes around in leap years
+    static const uint8_t month_days[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if(month < 1 || month > 12 || day < 1 || day > month_days[month - 1])
+        return false;
+    if(name_len > BIRTHDAY_NAME_MAX){
+        // Cut in front of the character that doesn't fit, not through it
+        name_len = BIRTHDAY_NAME_MAX;
+        while(name_len > 0 && ((uint8_t)name[name_len] & 0xC0) == 0x80)
+            name_len--;
+    }
+    if(index->count >= BIRTHDAY_MAX || index->pool_used + name_len + 1 > BIRTHDAY_POOL_SIZE){
+        APP_LOG(APP_LOG_LEVEL_WARNING, "Birthday index full at %d entries", index->count);
+        return false;
+    }
+
+    index->entries[index->count].day = birthday_day(month, day);
+    index->entries[index->count].name = index->pool_used;
+    memcpy(&index->pool[index->pool_used], name, name_len);
+    index->pool[index->pool_used + name_len] = '\0';
+    index->pool_used += name_len + 1;
+    index->count++;
+    return true;
+}
+
+void birthdays_clear(void){
+    index_clear(s_index);
+}
+
+bool birthdays_add(int month, int day, const char *name, size_t name_len){
+    return index_add(s_index, month, day, name, name_len);
+}
+
+bool birthdays_commit(void){
+    // Insertion sort keeps the list order for birthdays on the same day
+    BirthdayEntry *entries = s_index->entries;
+    for(int i = 1; i < s_index->count; i++){
+        BirthdayEntry entry = entries[i];
+        int j = i - 1;
+        while(j >= 0 && entries[j].day > entry.day){
+            entries[j + 1] = entries[j];
+            j--;
+        }
+        entries[j + 1] = entry;
+    }
+
+    s_header = (BirthdayHeader){
+        .version = BIRTHDAY_INDEX_VERSION,
+        .count = s_index->count,
+        .pool_used = s_index->pool_used,
+    };
+    // The header goes last, so it never points at entries that weren't stored
+    if(!persist_write_chunked(KEY_BDAY_ENTRIES, KEY_BDAY_NAMES, entries, s_index->count * sizeof(BirthdayEntry)) ||
+       !persist_write_chunked(KEY_BDAY_NAMES, KEY_BDAY_END, s_index->pool, s_index->pool_used) ||
+       !journal_write(KEY_BDAY_HEADER, &s_header, sizeof(s_header))){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Birthday index of %d entries couldn't be stored", s_index->count);
+        persist_delete(KEY_BDAY_HEADER);
+        return false;
+    }
+    return true;
+}
+
+bool birthdays_load(void){
+    BirthdayHeader header;
+    birthdays_clear();
+    PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+    if(persist_read_data(KEY_BDAY_HEADER, &header, sizeof(header)) != sizeof(header))
+        return false;
+    if(header.version != BIRTHDAY_INDEX_VERSION || header.count > BIRTHDAY_MAX || header.pool_used > BIRTHDAY_POOL_SIZE)
+        return false;
+
+    if(!persist_read_chunked(KEY_BDAY_ENTRIES, s_index->entries, header.count * sizeof(BirthdayEntry)) ||
+       !persist_read_chunked(KEY_BDAY_NAMES, s_index->pool, header.pool_used)){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Birthday index is corrupt");
+        return false;
+    }
+
+    s_index->count = header.count;
+    s_index->pool_used = header.pool_used;
+    return true;
+}
+
+/** Parse a positive number, advancing past it **/
+static int parse_number(const char **cursor, const char *end){
+    int value = 0;
+    while(*cursor < end && **cursor >= '0' && **cursor <= '9'){
+        value = value * 10 + (**cursor - '0');
+        (*cursor)++;
+    }
+    return value;
+}
+
+void birthdays_import_list(const char *list){
+    birthdays_clear();
+    if(list != NULL){
+        const char *cursor = list;
+        while(*cursor != '\0'){
+            // Name
+            const char *name = cursor;
+            size_t name_len = strcspn(cursor, ",");
+            cursor += name_len;
+            if(*cursor != ',')
+                break;
+            cursor++;
+
+            // Date
+            const char *date_end = cursor + strcspn(cursor, ",");
+            int month = parse_number(&cursor, date_end);
+            if(cursor < date_end && *cursor == '/')
+                cursor++;
+            int day = parse_number(&cursor, date_end);
+
+            birthdays_add(month, day, name, name_len);
+
+            cursor = date_end;
+            if(*cursor == ',')
+                cursor++;
+        }
+    }
+    birthdays_commit();
+}
+
+bool birthdays_decode_chunk(const uint8_t *data, size_t length){
+    if(length < BIRTHDAY_CHUNK_HEADER || data[0] != BIRTHDAY_FORMAT_VERSION){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Bad birthday chunk");
+        return false;
+    }
+
+    uint8_t flags = data[1];
+    uint8_t count = data[2];
+    if(flags & BIRTHDAY_CHUNK_FIRST){
+        // A transfer that never finished is dropped with its staged records
+        index_clear(s_staging);
+        s_announced = 0;
+        s_decoded = 0;
+        s_receiving = true;
+    }
+    if(!s_receiving)
+        return false;
+
+    size_t offset = BIRTHDAY_CHUNK_HEADER;
+    for(int i = 0; i < count; i++){
+        if(offset + BIRTHDAY_RECORD_HEADER > length)
+            break;
+        const uint8_t *record = data + offset;
+        size_t name_len = record[2];
+        if(offset + BIRTHDAY_RECORD_HEADER + name_len > length)
+            break;
+
+        // Days that don't exist and a full index only drop the record, the list still applies
+        index_add(s_staging, record[0], record[1], (const char *)record + BIRTHDAY_RECORD_HEADER, name_len);
+        offset += BIRTHDAY_RECORD_HEADER + name_len;
+        s_decoded++;
+    }
+    s_announced += count;
+    if(offset != length)
+        APP_LOG(APP_LOG_LEVEL_WARNING, "Birthday chunk truncated at %d of %d bytes", (int)offset, (int)length);
+
+    if(!(flags & BIRTHDAY_CHUNK_LAST))
+        return false;
+
+    s_receiving = false;
+    if(s_decoded != s_announced){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Birthday list dropped, %d of %d records arrived", s_decoded, s_announced);
+        return false;
+    }
+    BirthdayIndex *received = s_staging;
+    s_staging = s_index;
+    s_index = received;
+    birthdays_commit();
+    return true;
+}
+
+/** First entry on or after a day, the count if there is none **/
+static int lower_bound(uint16_t key){
+    int low = 0, high = s_index->count;
+    while(low < high){
+        int mid = (low + high) / 2;
+        if(s_index->entries[mid].day < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+const char *birthdays_find(int month, int day){
+    uint16_t key = birthday_day(month, day);
+
+    // Lower bound, so the first birthday of the day wins
+    int low = lower_bound(key);
+    if(low < s_index->count && s_index->entries[low].day == key)
+        return &s_index->pool[s_index->entries[low].name];
+    return NULL;
+}
+
+int birthdays_upcoming(uint16_t day, BirthdayRef *out, int max){
+    int count = max < s_index->count ? max : s_index->count;
+    int first = lower_bound(day);
+    for(int i = 0; i < count; i++){
+        const BirthdayEntry *entry = &s_index->entries[(first + i) % s_index->count];
+        out[i] = (BirthdayRef){
+            .day = entry->day,
+            .name = &s_index->pool[entry->name],
+        };
+    }
+    return count;
+}
+
+int birthdays_count(void){
+    return s_index->count;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <pebble.h>
+
+// Longest name kept, longer names are cut
+#define BIRTHDAY_NAME_MAX 20
+// Largest chunk the phone sends, header included
+#define BIRTHDAY_MESSAGE_MAX 96
+
+// Share of the 4 KB persist quota the index may take. The calendar keeps
+// 772 bytes, the settings, weather and forecast under 100 more
+#define BIRTHDAY_PERSIST_BUDGET 2048
+
+// 4 bytes an entry plus about 10 of name each, inside the budget
+#ifdef PBL_PLATFORM_APLITE
+#define BIRTHDAY_MAX 64
+#define BIRTHDAY_POOL_SIZE 640
+#else
+#define BIRTHDAY_MAX 128
+#define BIRTHDAY_POOL_SIZE 1280
+#endif
+
+/** A birthday by its day of a leap year, 0 based so Feb 29 is 59 **/
+typedef struct {
+    uint16_t day;
+    const char *name;
+} BirthdayRef;
+
+/** Empty the index, before adding a new list **/
+void birthdays_clear(void);
+
+/** Add a birthday, false once the index or the name pool is full **/
+bool birthdays_add(int month, int day, const char *name, size_t name_len);
+
+/** Sort the index after adding and persist it, false if it couldn't be stored **/
+bool birthdays_commit(void);
+
+/** Read the persisted index, false if there is none **/
+bool birthdays_load(void);
+
+/** Replace the index with a "Name,MM/DD,Name,MM/DD" list **/
+void birthdays_import_list(const char *list);
+
+/**
+ * Decode one chunk of a binary birthday list sent by the phone:
+ * [version][flags][count] then count x [month][day][name length][name].
+ * The list replaces the index with its last chunk, and only when every
+ * record the chunks announced arrived. Returns true once it has.
+ **/
+bool birthdays_decode_chunk(const uint8_t *data, size_t length);
+
+/** Name of the first birthday on a day, NULL if there is none **/
+const char *birthdays_find(int month, int day);
+
+/**
+ * Up to max birthdays from a day of a leap year on, in date order, wrapping
+ * past the end of the year. Names stay valid until the index changes.
+ **/
+int birthdays_upcoming(uint16_t day, BirthdayRef *out, int max);
+
+/** Number of birthdays in the index **/
+int birthdays_count(void);
@@ -0,0 +1,147 @@
+#include <pebble.h>
+#include "bitmap_cache.h"
+#include "profile.h"
+
+// A couple of backgrounds fit next to the one on screen
+#define BITMAP_CACHE_SLOTS 3
+#ifdef PBL_PLATFORM_APLITE
+#define BITMAP_CACHE_BUDGET 4096
+#else
+#define BITMAP_CACHE_BUDGET 12288
+#endif
+
+typedef struct {
+    uint32_t resource_id;
+    GBitmap *bitmap;
+    size_t bytes;
+    uint32_t last_used;
+} CacheEntry;
+
+static CacheEntry s_entries[BITMAP_CACHE_SLOTS];
+static CacheEntry *s_pinned;
+static uint32_t s_clock;
+static BitmapCacheStats s_stats;
+
+/** Decoded size of a bitmap's pixel data **/
+static size_t bitmap_bytes(GBitmap *bitmap){
+    GRect bounds = gbitmap_get_bounds(bitmap);
+    return (size_t)gbitmap_get_bytes_per_row(bitmap) * bounds.size.h;
+}
+
+static void record_heap(void){
+    size_t used = heap_bytes_used();
+    if(used > s_stats.peak_heap)
+        s_stats.peak_heap = used;
+}
+
+static void entry_destroy(CacheEntry *entry){
+    s_stats.bytes -= entry->bytes;
+    gbitmap_destroy(entry->bitmap);
+    *entry = (CacheEntry){ 0 };
+}
+
+static CacheEntry *find_entry(uint32_t resource_id){
+    for(int i = 0; i < BITMAP_CACHE_SLOTS; i++){
+        if(s_entries[i].bitmap != NULL && s_entries[i].resource_id == resource_id)
+            return &s_entries[i];
+    }
+    return NULL;
+}
+
+/** Least recently used entry that isn't on screen **/
+static CacheEntry *find_victim(void){
+    CacheEntry *victim = NULL;
+    for(int i = 0; i < BITMAP_CACHE_SLOTS; i++){
+        CacheEntry *entry = &s_entries[i];
+        if(entry->bitmap == NULL || entry == s_pinned)
+            continue;
+        if(victim == NULL || entry->last_used < victim->last_used)
+            victim = entry;
+    }
+    return victim;
+}
+
+/** Evict until the budget has room for a new bitmap and a slot is free **/
+static CacheEntry *make_room(size_t bytes){
+    CacheEntry *victim;
+    while(s_stats.bytes + bytes > BITMAP_CACHE_BUDGET && (victim = find_victim()) != NULL){
+        entry_destroy(victim);
+        s_stats.evictions++;
+    }
+
+    for(int i = 0; i < BITMAP_CACHE_SLOTS; i++){
+        if(s_entries[i].bitmap == NULL)
+            return &s_entries[i];
+    }
+
+    victim = find_victim();
+    if(victim != NULL){
+        entry_destroy(victim);
+        s_stats.evictions++;
+    }
+    return victim;
+}
+
+static CacheEntry *load_entry(uint32_t resource_id){
+    CacheEntry *entry = find_entry(resource_id);
+    if(entry != NULL){
+        s_stats.hits++;
+        entry->last_used = ++s_clock;
+        return entry;
+    }
+
+    s_stats.misses++;
+    GBitmap *bitmap = gbitmap_create_with_resource(resource_id);
+    PROFILE_COUNT(PROFILE_BITMAP_LOADS, 1);
+    PROFILE_SAMPLE_HEAP();
+    if(bitmap == NULL){
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "Image Missing: [%i]", (int)resource_id);
+        return NULL;
+    }
+
+    size_t bytes = bitmap_bytes(bitmap);
+    entry = make_room(bytes);
+    if(entry == NULL){
+        // Every slot is on screen, nothing can be cached
+        gbitmap_destroy(bitmap);
+        return NULL;
+    }
+
+    *entry = (CacheEntry){
+        .resource_id = resource_id,
+        .bitmap = bitmap,
+        .bytes = bytes,
+        .last_used = ++s_clock,
+    };
+    s_stats.bytes += bytes;
+    record_heap();
+    return entry;
+}
+
+GBitmap *bitmap_cache_acquire(uint32_t resource_id){
+    if(resource_id == 0)
+        return NULL;
+
+    CacheEntry *entry = load_entry(resource_id);
+    if(entry != NULL)
+        s_pinned = entry;
+    return entry != NULL ? entry->bitmap : NULL;
+}
+
+void bitmap_cache_prefetch(uint32_t resource_id){
+    if(resource_id == 0)
+        return;
+    load_entry(resource_id);
+}
+
+void bitmap_cache_flush(void){
+    for(int i = 0; i < BITMAP_CACHE_SLOTS; i++){
+        if(s_entries[i].bitmap != NULL)
+            entry_destroy(&s_entries[i]);
+    }
+    s_pinned = NULL;
+}
+
+void bitmap_cache_get_stats(BitmapCacheStats *stats){
+    *stats = s_stats;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <pebble.h>
+
+/** Counters for the background bitmap cache **/
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    size_t bytes;
+    size_t peak_heap;
+} BitmapCacheStats;
+
+/** Get a bitmap for a resource, loading it on a miss, and pin it as the displayed one **/
+GBitmap *bitmap_cache_acquire(uint32_t resource_id);
+
+/** Load a bitmap ahead of time without displaying it **/
+void bitmap_cache_prefetch(uint32_t resource_id);
+
+/** Destroy every cached bitmap **/
+void bitmap_cache_flush(void);
+
+/** Copy out the cache counters **/
+void bitmap_cache_get_stats(BitmapCacheStats *stats);
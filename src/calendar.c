@@ -0,0 +1,159 @@
+#include <pebble.h>
+#include "calendar.h"
+#include "holidays.h"
+#include "profile.h"
+#include "journal.h"
+
+// Persist keys 70-79 belong to the calendar
+#define KEY_CALENDAR_HEADER 70
+#define KEY_CALENDAR_DAYS 71
+
+#define CALENDAR_STORE_VERSION 1
+#define CALENDAR_CHUNK_DAYS (PERSIST_DATA_MAX_LENGTH / sizeof(HolidayDay))
+
+// Day table sent by the phone
+#define CALENDAR_FORMAT_VERSION 1
+#define CALENDAR_CHUNK_FULL 0x01
+#define CALENDAR_CHUNK_LAST 0x02
+#define CALENDAR_CHUNK_HEADER 7
+
+typedef struct {
+    uint8_t version;
+    bool complete;
+    uint16_t year;
+} CalendarHeader;
+
+// Year to ask the phone for a whole table of, 0 when none is owed
+static uint16_t s_resync_year;
+// Year already asked for, further chunks it couldn't apply don't ask again until a table arrives
+static uint16_t s_resync_asked;
+
+static void ask_resync(int year){
+    if(year != s_resync_asked)
+        s_resync_year = year;
+}
+
+/** Write days into the persisted table, touching only the keys they fall in **/
+static void store_days(int first, const HolidayDay *days, int count){
+    HolidayDay chunk[CALENDAR_CHUNK_DAYS];
+    int day = first;
+    while(day < first + count){
+        int index = day / CALENDAR_CHUNK_DAYS;
+        int start = index * CALENDAR_CHUNK_DAYS;
+        int end = start + CALENDAR_CHUNK_DAYS;
+        if(end > first + count)
+            end = first + count;
+
+        memset(chunk, 0, sizeof(chunk));
+        persist_read_data(KEY_CALENDAR_DAYS + index, chunk, sizeof(chunk));
+        PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+        memcpy(&chunk[day - start], &days[day - first], (end - day) * sizeof(HolidayDay));
+        journal_write(KEY_CALENDAR_DAYS + index, chunk, sizeof(chunk));
+        day = end;
+    }
+}
+
+static void store_header(int year, bool complete){
+    CalendarHeader header = {
+        .version = CALENDAR_STORE_VERSION,
+        .complete = complete,
+        .year = year,
+    };
+    journal_write(KEY_CALENDAR_HEADER, &header, sizeof(header));
+}
+
+/** Put the stored table in place, asking for a resync when it isn't the year's only if resync is set **/
+static bool load_table(int year, bool resync){
+    CalendarHeader header;
+    PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+    if(persist_read_data(KEY_CALENDAR_HEADER, &header, sizeof(header)) != sizeof(header) ||
+       header.version != CALENDAR_STORE_VERSION)
+        return false;
+    if(!header.complete || header.year != year){
+        // The phone keeps tables up to date, one for another year or cut short means it has to send this one
+        if(resync)
+            ask_resync(year);
+        return false;
+    }
+
+    HolidayDay chunk[CALENDAR_CHUNK_DAYS];
+    for(int start = 0; start < HOLIDAY_TABLE_DAYS; start += CALENDAR_CHUNK_DAYS){
+        PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+        if(persist_read_data(KEY_CALENDAR_DAYS + start / CALENDAR_CHUNK_DAYS, chunk, sizeof(chunk)) != sizeof(chunk)){
+            APP_LOG(APP_LOG_LEVEL_ERROR, "Calendar table is corrupt");
+            return false;
+        }
+        holidays_set_days(year, start, chunk, CALENDAR_CHUNK_DAYS);
+    }
+    // Whatever was asked for before, the table on screen is the phone's now
+    s_resync_year = 0;
+    s_resync_asked = 0;
+    return true;
+}
+
+bool calendar_load(int year){
+    return load_table(year, true);
+}
+
+bool calendar_load_ahead(int year){
+    return load_table(year, false);
+}
+
+bool calendar_decode_chunk(const uint8_t *data, size_t length){
+    if(length < CALENDAR_CHUNK_HEADER || data[0] != CALENDAR_FORMAT_VERSION){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Bad calendar chunk");
+        return false;
+    }
+
+    uint8_t flags = data[1];
+    int year = data[2] | data[3] << 8;
+    int first = data[4] | data[5] << 8;
+    int count = data[6];
+    if(first + count > HOLIDAY_TABLE_DAYS ||
+       length < CALENDAR_CHUNK_HEADER + count * sizeof(HolidayDay)){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Bad calendar chunk");
+        return false;
+    }
+    const HolidayDay *days = (const HolidayDay *)(data + CALENDAR_CHUNK_HEADER);
+
+    // Only the year on screen is stored, the table in persist is the one the face reloads
+    if(holidays_year() != 0 && year != holidays_year()){
+        APP_LOG(APP_LOG_LEVEL_WARNING, "Calendar for %d while showing %d", year, holidays_year());
+        ask_resync(holidays_year());
+        return false;
+    }
+
+    if(flags & CALENDAR_CHUNK_FULL){
+        // A full send is staged in persist and only shown once it is all there
+        if(first == 0)
+            store_header(year, false);
+        store_days(first, days, count);
+        if(!(flags & CALENDAR_CHUNK_LAST))
+            return false;
+        store_header(year, true);
+        return calendar_load(year);
+    }
+
+    // Deltas only patch a table the watch already has from the phone
+    if(!holidays_from_phone()){
+        ask_resync(year);
+        return false;
+    }
+    store_days(first, days, count);
+    holidays_set_days(year, first, days, count);
+    return true;
+}
+
+void calendar_request_resync(void){
+    if(s_resync_year == 0)
+        return;
+
+    DictionaryIterator *iter;
+    if(app_message_outbox_begin(&iter) != APP_MSG_OK)
+        return;
+    dict_write_uint16(iter, KEY_CALENDAR_RESYNC, s_resync_year);
+    if(app_message_outbox_send() == APP_MSG_OK){
+        s_resync_asked = s_resync_year;
+        s_resync_year = 0;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+
+// AppMessage key of the day table computed by the phone
+#define KEY_CALENDAR 11
+// Largest chunk the phone sends: a 7 byte header then up to 96 days of 2 bytes
+#define CALENDAR_MESSAGE_MAX (7 + 96 * 2)
+// Sent back with the year the watch needs a whole table for, when chunks couldn't be applied
+#define KEY_CALENDAR_RESYNC 14
+
+/** Put the phone's table for a year back in place, false if there is none. One for another year asks for a resync **/
+bool calendar_load(int year);
+
+/** calendar_load() for a year looked ahead at, one the phone hasn't sent yet is left to its own midnight **/
+bool calendar_load_ahead(int year);
+
+/**
+ * A piece of the day table arrived from the phone:
+ * [version][flags][year, uint16][first day, uint16][count] then count x [image][banner],
+ * little endian. Full sends start at day 0 and end with the LAST flag, deltas
+ * patch the year already held. Chunks for a year the watch isn't showing, or
+ * deltas without a table to patch, are dropped and a resync is asked for.
+ * Returns true when what the watch shows may have changed.
+ **/
+bool calendar_decode_chunk(const uint8_t *data, size_t length);
+
+/** Ask the phone for a whole table if one is owed, again once the outbox is free if it is busy **/
+void calendar_request_resync(void);
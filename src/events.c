@@ -0,0 +1,133 @@
+#include <pebble.h>
+#include "events.h"
+#include "holidays.h"
+#include "birthdays.h"
+#include "text.h"
+#include "string_table.h"
+
+// Day of a leap year that only exists in leap years
+#define LEAP_DAY 59
+
+/** A holiday or birthday by day of the table year, later days fall in the next year **/
+typedef struct {
+    int16_t day;
+    uint8_t banner;     // holidays, the name comes from the string table
+    const char *name;   // birthdays
+} Event;
+
+static Event s_events[EVENTS_MAX];
+static uint8_t s_count;
+static uint8_t s_cursor;
+static int s_year;
+static int s_today;
+
+static bool is_leap_year(int year){
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int days_in_year(int year){
+    return is_leap_year(year) ? 366 : 365;
+}
+
+/** Insert in day order into a list of at most EVENTS_MAX, after events already on that day **/
+static void insert_event(Event *events, int *count, Event event){
+    int i = *count < EVENTS_MAX ? (*count)++ : EVENTS_MAX;
+    while(i > 0 && events[i - 1].day > event.day){
+        if(i < EVENTS_MAX)
+            events[i] = events[i - 1];
+        i--;
+    }
+    if(i < EVENTS_MAX)
+        events[i] = event;
+}
+
+/** Next holidays left in the table, the table only knows the current year **/
+static void collect_holidays(Event *events, int *count, int from){
+    int found = 0;
+    for(int day = from; day < HOLIDAY_TABLE_DAYS && found < EVENTS_MAX; day++){
+        uint8_t banner = holidays_lookup(day).banner;
+        if(!holidays_is_event(banner))
+            continue;
+        insert_event(events, count, (Event){ .day = day, .banner = banner });
+        found++;
+    }
+}
+
+/** Next birthdays from the sorted index, wrapping into the next year **/
+static void collect_birthdays(Event *events, int *count, int from){
+    bool leap = is_leap_year(s_year);
+    uint16_t start = !leap && from >= LEAP_DAY ? from + 1 : from;
+
+    BirthdayRef upcoming[EVENTS_MAX];
+    int found = birthdays_upcoming(start, upcoming, EVENTS_MAX);
+    for(int i = 0; i < found; i++){
+        // Feb 29 birthdays only come around in leap years
+        int day = upcoming[i].day;
+        if(!leap && day == LEAP_DAY)
+            continue;
+        if(!leap && day > LEAP_DAY)
+            day--;
+        if(day < from)
+            day += days_in_year(s_year);
+        insert_event(events, count, (Event){ .day = day, .name = upcoming[i].name });
+    }
+}
+
+/** Countdown text for the first event, written once per day **/
+static void format_banner(void){
+    char *text = text_buffer(TEXT_COUNTDOWN);
+    text[0] = '\0';
+    if(s_cursor >= s_count)
+        return;
+
+    const Event *next = &s_events[s_cursor];
+    int days = next->day - s_today;
+    if(days > EVENTS_HORIZON)
+        return;
+
+    char unit[STRING_SIZE], name[STRING_SIZE];
+    string_table_get(days == 1 ? STRING_DAY : STRING_DAYS, unit, sizeof(unit));
+    if(next->name != NULL){
+        text_format_string(TEXT_COUNTDOWN, STRING_COUNTDOWN_BIRTHDAY, "%d %s to %s's birthday", days, unit, next->name);
+    }else{
+        text_format_string(TEXT_COUNTDOWN, STRING_COUNTDOWN_HOLIDAY, "%s in %d %s",
+                           string_table_get(STRING_EVENT(next->banner), name, sizeof(name)), days, unit);
+    }
+}
+
+void events_refresh(int year, int yday){
+    Event events[EVENTS_MAX];
+    int count = 0;
+
+    s_year = year;
+    s_today = yday;
+    collect_holidays(events, &count, yday + 1);
+    collect_birthdays(events, &count, yday + 1);
+
+    memcpy(s_events, events, count * sizeof(Event));
+    s_count = count;
+    s_cursor = 0;
+    format_banner();
+}
+
+void events_advance(int year, int yday){
+    if(year != s_year || yday < s_today){
+        events_refresh(year, yday);
+        return;
+    }
+
+    // At most EVENTS_MAX steps, however many birthdays there are
+    s_today = yday;
+    while(s_cursor < s_count && s_events[s_cursor].day <= yday)
+        s_cursor++;
+    if(s_cursor == s_count){
+        events_refresh(year, yday);
+        return;
+    }
+    format_banner();
+}
+
+const char *events_banner(void){
+    const char *text = text_get(TEXT_COUNTDOWN);
+    return text[0] != '\0' ? text : NULL;
+}
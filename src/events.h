@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pebble.h>
+
+// Upcoming events kept between rebuilds
+#define EVENTS_MAX 4
+// Days ahead a countdown is shown for
+#define EVENTS_HORIZON 14
+
+/** Collect the next events after a day of the loaded holiday year, after the table or birthdays changed **/
+void events_refresh(int year, int yday);
+
+/** Move on to a new day, only rebuilding once the collected events have all passed **/
+void events_advance(int year, int yday);
+
+/** Countdown to the next event within the horizon, NULL if there is none **/
+const char *events_banner(void);
@@ -1,43 +1,41 @@
 #include <pebble.h>
 #include <time.h>
+#include <locale.h>
 #include <stdlib.h>
-
-#define KEY_TEMPERATURE 0
-
-#define KEY_TWENTY_FOUR_HOUR_FORMAT 1
-#define KEY_BATTERY_ON_OFF 2
-#define KEY_TEMP_TYPE 3
-#define KEY_BIRTHDAY_LIST 4
-#define KEY_INVERT_COLOR 5
+#include "holidays.h"
+#include "calendar.h"
+#include "bitmap_cache.h"
+#include "birthdays.h"
+#include "render.h"
+#include "weather.h"
+#include "settings.h"
+#include "profile.h"
+#include "power.h"
+#include "text.h"
+#include "panel.h"
+#include "journal.h"
+#include "messages.h"
+#include "events.h"
+#include "string_table.h"
 
 #define KEY_BDAY_LIST_SIZE 20
 
-typedef struct
-{
-	char date[5];
-	char name[10];
-} Birthday;
-    
+// Tomorrow's background is loaded this close to midnight, so two bitmaps are held only briefly
+#define PREFETCH_HOUR 23
+#define PREFETCH_MINUTE 55
+
 enum Colors{
 	BLACK,
 	WHITE
 };
 
 static Window *window;
-static TextLayer *s_time_layer, *s_date_layer, *s_weekday_layer, *s_weather_layer;
+static TextLayer *s_time_layer, *s_date_layer, *s_weather_layer;
 
-static bool twenty_four_hour_format = false;
-static bool battery_on_off = false;
-
-static char* temperature_format = "Fahrenheit";
-static int initTemp = 5000;
-
-static char birthday_list[(sizeof(Birthday)+1)*10];
-static int birthday_list_size = 0;
+static Settings s_settings;
 
 static int background_color = BLACK;
 static int foreground_color = WHITE;
-static bool is_inverted = false;
 
 // Battery
 static Layer *s_battery_layer;
@@ -45,22 +43,37 @@ static Layer *s_divider_layer;
 static int s_battery_level;
 
 // Bluetooth
-static BitmapLayer *s_bt_icon_layer;
-static GBitmap *s_bt_icon_bitmap;
+static bool s_bt_connected = true;
 
-// Background
-static BitmapLayer *s_background_layer;
+// Config version still to be confirmed to the phone, 0 when none is owed
+static uint16_t s_config_owed;
+
+// Background, banner and Bluetooth icon share the upper panel
+static Layer *s_panel_layer;
 static GBitmap *s_background_bitmap;
 
-// Birthday
-static Birthday birthdays[10];
+/** What the tick pipeline derived, each part is redone only when its unit changes **/
+typedef struct {
+    struct tm now;          // last tick the pipeline ran on
+    bool valid;
+    int year;               // year stage: the holiday table is loaded for it
+    char month[8];          // month stage: abbreviated month name
+    uint32_t resource;      // day stage: background and banner of the day
+    const char *banner;
+} TickState;
+
+static TickState s_tick;
 
 /** Update bluetooth logic **/
 static void bluetooth_callback(bool connected){
     // Show icon if disconnected
-    layer_set_hidden(bitmap_layer_get_layer(s_bt_icon_layer), connected);
+    if(connected != s_bt_connected){
+        s_bt_connected = connected;
+        panel_set_bt_visible(!connected);
+        weather_connection_changed(connected);
+    }
     
-    if(!connected){
+    if(!connected && power_policy()->vibrate){
         // Issue a vibrating alert
         vibes_double_pulse();
     }
@@ -78,7 +91,7 @@ static void battery_update_proc(Layer *layer, GContext *ctx){
     graphics_fill_rect(ctx, bounds, 0, GCornerNone);
     
     // Draw the bar	
-	if(battery_on_off){
+	if(s_settings.battery_on){
 		graphics_context_set_fill_color(ctx, foreground_color ? GColorWhite : GColorBlack);
 		graphics_fill_rect(ctx, GRect((123 - width) / 2, 0, width, 3), 0, GCornerNone);
     }
@@ -94,379 +107,325 @@ static void divider_update_proc(Layer *layer, GContext *ctx){
     graphics_fill_rect(ctx, bounds, 0, GCornerNone);
 }
 
+static void apply_power_policy(void);
+
 /** Update battery logic **/
 static void battery_callback(BatteryChargeState state){
+    // Plugging in can move the tier without changing the level
+    if(power_update(state))
+        apply_power_policy();
+
     // Record the new battery level
+    if(state.charge_percent == s_battery_level)
+        return;
     s_battery_level = state.charge_percent;
     
-    // Update meter
-    layer_mark_dirty(s_battery_layer);
+    // Update meter, only drawn when the bar is on
+    if(s_settings.battery_on)
+        render_invalidate(RENDER_BATTERY);
 }
 
-static uint16_t thursdayThoughts(){
-    int n = rand() % 2 + 1; // [1,2]
+/** Use the phone's table for the year, or compile the built-in rules without it **/
+static void load_year(int year){
+	if(holidays_year() != year && !calendar_load(year))
+		holidays_compile(year);
+}
 
-    char* thoughtStr = "";
+/** Get background resource and banner for the given day **/
+static uint32_t get_background_resource(const struct tm *tick_time, const char **banner){
+	load_year(tick_time->tm_year + 1900);
 
-    switch(n){
-        case 1: strcpy(thoughtStr, "Live what you love"); break;
-        case 2: strcpy(thoughtStr, "You get what you settle for"); break;
-        default: strcpy(thoughtStr, "Thursday Thoughts"); break;
-    }
-    
-    text_layer_set_text(s_weekday_layer, thoughtStr);
-    return 0;
-}
-
-/** Get resource for normal weekdays **/
-static uint16_t normalWeekday(int weekday){
-	switch(weekday){
-		case 0: return RESOURCE_ID_IMAGE_SUNDAY;
-        case 1: return RESOURCE_ID_IMAGE_MONDAY;
-        case 2: return RESOURCE_ID_IMAGE_TUESDAY;
-		case 3: return RESOURCE_ID_IMAGE_CAMEL;
-        case 4: thursdayThoughts(); return 0;
-		case 5: return RESOURCE_ID_IMAGE_FRIDAY;
-        case 6: return RESOURCE_ID_IMAGE_SATURDAY;
-		default: break;		
-	}
-	return 0;
-}
+	HolidayDay today = holidays_lookup(tick_time->tm_yday);
 
-static int countChar(char* string, char delim){
-	int charCount = 0;
-	for(int i = 0; i < (int)strlen(string); i++){
-		if(string[i] == delim)
-			charCount++;
-	}
-	return charCount + 1;
-}
-
-/** Get background resource for special days **/
-static uint16_t get_background_resource(int month, int day, int weekday){
-	text_layer_set_text(s_weekday_layer, NULL);
-	// Check for birthdays
-	for(int i = 0; i < 10; i++){
-		if(birthdays[i].name == NULL)
-			continue;
-
-	    int bday_month_tens = ((birthdays[i].date)[0] - '0')*10; 
-	    int bday_month_ones = ((birthdays[i].date)[1] - '0');
-	    int bday_month = bday_month_tens + bday_month_ones;
-	    
-	    int bday_day_tens = ((birthdays[i].date)[3] - '0')*10;
-	    int bday_day_ones = ((birthdays[i].date)[4] - '0');
-	    int bday_day = bday_day_tens + bday_day_ones;
-
-	    if(bday_month == month && bday_day == day){
-	        char* bdaystr = "";
-			strcpy(bdaystr, (char*)birthdays[i].name);
-	        strcat(bdaystr, "'s Birthday!");
-	        text_layer_set_text(s_weekday_layer, bdaystr);
-	        return RESOURCE_ID_IMAGE_BIRTHDAY;
-	    }
+	// Birthdays are already in the phone's table, the built-in rules don't know them
+	const char *name = NULL;
+	if(today.banner == BANNER_BIRTHDAY || !holidays_from_phone())
+		name = birthdays_find(tick_time->tm_mon + 1, tick_time->tm_mday);
+	if(name != NULL){
+		if(banner != NULL){
+			*banner = text_format_string(TEXT_BANNER, STRING_BIRTHDAY_GREETING, "%s's Birthday!", name);
+		}
+		return holidays_image_resource(HOLIDAY_IMAGE_BIRTHDAY);
 	}
 
-    switch(month){
-		case 1:
-			switch(day){
-				case 1: 
-	        		text_layer_set_text(s_weekday_layer, "Happy New Year!");
-					return RESOURCE_ID_IMAGE_NEW_YEARS;
-                default: return normalWeekday(weekday);
-			}
-		case 2:
-			switch(day){
-				case 14: 
-	        		text_layer_set_text(s_weekday_layer, "Valentine's Day!");
-					return RESOURCE_ID_IMAGE_VALENTINE;
-                default: return normalWeekday(weekday);
-			}
-		case 3:
-			switch(day){
-				case 17: 
-	        		text_layer_set_text(s_weekday_layer, "St. Patrick's Day!");
-					return RESOURCE_ID_IMAGE_ST_PATRICK;
-				case 20:
-				case 21: 
-	        		text_layer_set_text(s_weekday_layer, "Happy Spring!");
-					return RESOURCE_ID_IMAGE_SPRING;
-                default: return normalWeekday(weekday);
-			}
-        case 4:
-            switch(day){
-				case 1: 
-	        		text_layer_set_text(s_weekday_layer, "April Fools!");
-					return RESOURCE_ID_IMAGE_APRIL_FOOLS;
-				default: return RESOURCE_ID_IMAGE_RABBIT;
-			}
-		case 5:
-			switch(day){
-				case 5: 
-	        		text_layer_set_text(s_weekday_layer, "Happy Cinco de Mayo!");
-					return RESOURCE_ID_IMAGE_CINCO_DE_MAYO;
-                default: return normalWeekday(weekday);
-			}
-		case 6:
-			switch(day){
-				case 22:
-				case 23: 
-	        		text_layer_set_text(s_weekday_layer, "Happy Summer!");
-					return RESOURCE_ID_IMAGE_SUMMER;
-                default: return normalWeekday(weekday);
-			}
-		case 7:
-			switch(day){
-				case 4: 
-	        		text_layer_set_text(s_weekday_layer, "Happy 4th of July!");
-					return RESOURCE_ID_IMAGE_FOURTH_OF_JULY;
-                default: return normalWeekday(weekday);
-			}
-		case 9:
-			switch(day){
-				case 22:
-				case 23: 
-	        		text_layer_set_text(s_weekday_layer, "Happy Fall!");
-					return RESOURCE_ID_IMAGE_FALL;
-                default: return normalWeekday(weekday);                   
-			}
-        case 10:
-            switch(day){
-				case 25:
-				case 26:
-				case 27:
-				case 28:
-                case 29:
-                case 30:
-	        		text_layer_set_text(s_weekday_layer, NULL);
-					return RESOURCE_ID_IMAGE_10_31;
-                case 31: 
-	        		text_layer_set_text(s_weekday_layer, "Happy Halloween!");
-					return RESOURCE_ID_IMAGE_10_31;
-                default: return normalWeekday(weekday);
-            }
-        case 11:
-            return RESOURCE_ID_IMAGE_TURKEY;
-        case 12:
-            switch(day){     
-                case 22: 
-	        		text_layer_set_text(s_weekday_layer, "Happy Winter!");
-		    	case 18:
-                case 19:
-                case 20:
-                case 21:
-                    return RESOURCE_ID_IMAGE_WINTER;
-                case 25: 
-	        		text_layer_set_text(s_weekday_layer, "Merry Christmas!");
-                case 23:
-				case 24:
-                case 26:
-                case 27:
-                case 28:
-                case 29:
-                case 30:
-                case 31:
-					return RESOURCE_ID_IMAGE_12_25;
-                default: return normalWeekday(weekday);
-            }
-        default:
-            return normalWeekday(weekday);
-    }
-    return 0;
-}
-
-/** Renders the time and date **/
-static void update_time(){
-    // Get a tm structure
-    time_t temp = time(NULL);
-    struct tm *tick_time = localtime(&temp);
-
-    // Create a long-lived buffer
-    static char buffer[] = "00:00";
-    static char date_buffer[] = "DDD, MMM DD";
-
-    // Write the current hours and minutes into the buffer
-    if(twenty_four_hour_format){
-        // Use 24 hour format
-        strftime(buffer, sizeof("00:00"), "%k:%M", tick_time);
-    } else {
-        // Use 12 hour format
-        strftime(buffer, sizeof("00:00"), "%l:%M", tick_time);
-    }
+	if(banner != NULL)
+		*banner = holidays_banner_text(today.banner);
+	return holidays_image_resource(today.image);
+}
 
-    strftime(date_buffer, sizeof("DDD, MMM DD"), "%a, %b %e", tick_time);
+/** Renders the time of the last tick, 24 or 12 hour format **/
+static void update_time(void){
+    const char *time_text = text_strftime(TEXT_TIME, s_settings.twenty_four_hour ? "%k:%M" : "%l:%M", &s_tick.now);
+	PROFILE_LOG("Time -> %s", time_text);
+    render_set_text(RENDER_TIME, time_text);
+}
 
-	APP_LOG(APP_LOG_LEVEL_DEBUG, "Time -> %s", buffer);
-	APP_LOG(APP_LOG_LEVEL_DEBUG, "Date -> %s", date_buffer);
+/** Works out the day's background and banner again, after birthdays or the table changed **/
+static void resolve_day(void){
+    s_tick.banner = NULL;
+    s_tick.resource = get_background_resource(&s_tick.now, &s_tick.banner);
 
-    text_layer_set_text(s_time_layer, buffer);
-    text_layer_set_text(s_date_layer, date_buffer);
+    // Quiet days count down to the next holiday or birthday
+    if(s_tick.banner == NULL)
+        s_tick.banner = events_banner();
 }
 
-/** Renders the background image **/
-static void update_image(){
+/** Renders the background image the day stage picked **/
+static void update_image(void){
+    GBitmap *bitmap = bitmap_cache_acquire(s_tick.resource);
+    s_background_bitmap = bitmap;
+    panel_set_background(bitmap);
+    panel_set_banner(s_tick.banner);
+
+#ifdef FESTIVE_PROFILE
+	BitmapCacheStats stats;
+	bitmap_cache_get_stats(&stats);
+	PROFILE_LOG("Bitmap cache: %d hits, %d misses, peak heap %d",
+		(int)stats.hits, (int)stats.misses, (int)stats.peak_heap);
+#endif
+}
 
-    // Get a tm structure
-    time_t temp = time(NULL);
-    struct tm *tick_time = localtime(&temp);
+/** Birthdays or the phone's table changed, the upcoming events go with them **/
+static void refresh_day(void){
+    load_year(s_tick.year);
+    events_refresh(s_tick.year, s_tick.now.tm_yday);
+    resolve_day();
+    update_image();
+}
 
-    // Create a long-lived buffer
-    static char date_buffer[] = "DDD, MMM DD";
-    strftime(date_buffer, sizeof("DDD, MMM DD"), "%a, %b %e", tick_time);
-    
-    // Update background based on day
-    char month[3], day[3], weekday[2];
-    strftime(month, sizeof(month), "%m", tick_time);
-    strftime(day, sizeof(day), "%d", tick_time);
-    strftime(weekday, sizeof(weekday), "%w", tick_time);
-
-    uint16_t RESOURCE_ID = get_background_resource(atoi(month), atoi(day), atoi(weekday));
-    s_background_bitmap = gbitmap_create_with_resource(RESOURCE_ID);
-    bitmap_layer_set_bitmap(s_background_layer, s_background_bitmap);
-    if(s_background_bitmap == NULL){
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "Image Missing: [%i]", RESOURCE_ID);
-    }
+/** Drops the background for a plain frame while saving power, freeing the cached bitmaps **/
+static void clear_image(void){
+    s_background_bitmap = NULL;
+    panel_set_background(NULL);
+    panel_set_banner(NULL);
+    bitmap_cache_flush();
+}
 
-	if(text_layer_get_text(s_weekday_layer) == NULL)
-		text_layer_set_background_color(s_weekday_layer, GColorClear);
-	else
-		text_layer_set_background_color(s_weekday_layer, background_color ? GColorWhite : GColorBlack);
-}
-
-static void parse_birthday_list(char* list){
-	APP_LOG(APP_LOG_LEVEL_DEBUG, "The birthday list is: %s", list);
-	char* temp = list;
-	if(temp != NULL){
-		int listSize = countChar(list, ',');
-		if(listSize%2 != 0) 
-			return;
-
-		int index = 0;
-		for(int i = 0; i < listSize && i < 16*2; i+=2){
-			char* src = temp;		
-		
-			// Name
-			int nameSize = strcspn(src, ",");
-			char name[10];		
-			memset(name, '\0', sizeof(name));
-			strncpy(name, src, nameSize);
-	
-			// Date
-			int dateSize = strcspn(src + nameSize + 1, ",");
-			char date[5];
-			memset(date, '\0', sizeof(date));
-			strncpy(date, src + nameSize + 1, dateSize);
+/** Loads tomorrow's background so midnight only swaps the bitmap **/
+static void prefetch_image(void){
+    time_t temp = time(NULL) + SECONDS_PER_DAY;
+    struct tm *tomorrow = localtime(&temp);
+
+    // Next year's table isn't asked for yet, the year stage does that at midnight
+    int year = tomorrow->tm_year + 1900;
+    if(holidays_year() != year && !calendar_load_ahead(year))
+        holidays_compile(year);
+    bitmap_cache_prefetch(get_background_resource(tomorrow, NULL));
+    // On Dec 31 that loaded next year's table, today's lookups still need this one
+    load_year(s_tick.year);
+}
 
-			strncpy(birthdays[index].name, name, sizeof(birthdays[index].name));
+static void update_temperature(void){
+	int temperature = 0;
+	const char *text;
 
-			strncpy(birthdays[index].date, date, sizeof(birthdays[index].date));
+	if(!weather_has_temperature()){
+    	render_set_text(RENDER_WEATHER, "...");
+		return;
+	}
 
-			strncpy(temp, temp + nameSize + dateSize + 2, strlen(temp));
+	// An old reading is shown with a trailing mark until it is refreshed
+	int reading = (int)weather_temperature();
+	const char *stale = weather_is_stale() ? "*" : "";
 
-			index++;
-		}
+	if(s_settings.temp_format == TEMP_FAHRENHEIT){
+		temperature = reading;
+		text = TEXT_FORMAT(TEXT_TEMPERATURE, "%d°F%s", temperature, stale);
+	}else if(s_settings.temp_format == TEMP_CELSIUS){
+		temperature = (reading - 32) * 5 / 9;
+		text = TEXT_FORMAT(TEXT_TEMPERATURE, "%d°C%s", temperature, stale);
+	}else{
+		temperature = (int)((double)reading + 459.67) * 5 / 9;
+		text = TEXT_FORMAT(TEXT_TEMPERATURE, "%d K%s", temperature, stale);
 	}
-	update_image();
+
+    render_set_text(RENDER_WEATHER, text);
 }
 
-static void update_temperature(char* temp_format){
-    static char temperature_buffer[8];
-	int temperature = 0;
+/** New year: the holiday table **/
+static void year_stage(const struct tm *tick_time){
+    s_tick.year = tick_time->tm_year + 1900;
+    load_year(s_tick.year);
+    // The phone's table for a new year is asked for right away
+    calendar_request_resync();
+}
 
-	printf(temp_format);
+/** New month: its name for the date **/
+static void month_stage(const struct tm *tick_time){
+    strftime(s_tick.month, sizeof(s_tick.month), "%b", tick_time);
+}
 
-	if(temp_format[0] == 'F'){
-		temperature = initTemp;
-		snprintf(temperature_buffer, sizeof(temperature_buffer), "%d°F", temperature);
-	}else if(temp_format[0] == 'C'){
-		temperature = (initTemp - 32) * 5 / 9;
-		snprintf(temperature_buffer, sizeof(temperature_buffer), "%d°C", temperature);
-	}else{
-		temperature = (int)((double)initTemp + 459.67) * 5 / 9;
-		snprintf(temperature_buffer, sizeof(temperature_buffer), "%d K", temperature);
-	}
+/** New day: the date, background and banner **/
+static void day_stage(const struct tm *tick_time){
+    char weekday[8];
+    strftime(weekday, sizeof(weekday), "%a", tick_time);
+    const char *date_text = TEXT_FORMAT(TEXT_DATE, "%s, %s %2d", weekday, s_tick.month, tick_time->tm_mday);
+	PROFILE_LOG("Date -> %s", date_text);
+    render_set_text(RENDER_DATE, date_text);
+
+    events_advance(s_tick.year, tick_time->tm_yday);
+    resolve_day();
+    if(power_policy()->swap_background)
+        update_image();
+    else
+        clear_image();
+}
+
+/** New hour: the temperature when saving power **/
+static void hour_stage(const struct tm *tick_time){
+    if(power_policy()->minute_only)
+        update_temperature();
+}
+
+/** New minute: the time and temperature, and tomorrow's background before midnight **/
+static void minute_stage(const struct tm *tick_time){
+    update_time();
+    if(!power_policy()->minute_only)
+        update_temperature();
+    if(tick_time->tm_hour == PREFETCH_HOUR && tick_time->tm_min == PREFETCH_MINUTE && power_policy()->swap_background)
+        prefetch_image();
+}
+
+/** Units that changed since the last run, a larger unit changes every smaller one **/
+static TimeUnits changed_units(const struct tm *tick_time, TimeUnits units_changed){
+    const struct tm *last = &s_tick.now;
+    if(!s_tick.valid || tick_time->tm_year != last->tm_year)
+        units_changed |= YEAR_UNIT;
+    if((units_changed & YEAR_UNIT) || tick_time->tm_mon != last->tm_mon)
+        units_changed |= MONTH_UNIT;
+    if((units_changed & MONTH_UNIT) || tick_time->tm_yday != last->tm_yday)
+        units_changed |= DAY_UNIT;
+    if((units_changed & DAY_UNIT) || tick_time->tm_hour != last->tm_hour)
+        units_changed |= HOUR_UNIT;
+    if((units_changed & HOUR_UNIT) || tick_time->tm_min != last->tm_min)
+        units_changed |= MINUTE_UNIT;
+    return units_changed;
+}
 
-	if(initTemp == 5000)
-    	text_layer_set_text(s_weather_layer, "...");
-	else	
-	    text_layer_set_text(s_weather_layer, temperature_buffer);
-    layer_mark_dirty(text_layer_get_layer(s_weather_layer));
+/** Runs the stages whose unit changed, largest first so smaller ones see their state **/
+static void run_tick_pipeline(const struct tm *tick_time, TimeUnits units_changed){
+    TimeUnits units = changed_units(tick_time, units_changed);
+    s_tick.now = *tick_time;
+    s_tick.valid = true;
+
+    if(units & YEAR_UNIT)
+        year_stage(tick_time);
+    if(units & MONTH_UNIT)
+        month_stage(tick_time);
+    if(units & DAY_UNIT)
+        day_stage(tick_time);
+    if(units & HOUR_UNIT)
+        hour_stage(tick_time);
+    if(units & MINUTE_UNIT)
+        minute_stage(tick_time);
 }
 
 /** Updates time logic **/
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed){
-    if( (units_changed & MINUTE_UNIT) != 0){
-        update_time();
-        
-        // Get weather update every 30 minutes
-        if(tick_time->tm_min % 30 == 0) {
-            // Begin dictionary
-            DictionaryIterator *iter;
-            app_message_outbox_begin(&iter);
-
-            // Add a key-value pair
-            dict_write_uint8(iter, 0, 0);
-
-            // Send the message!
-            app_message_outbox_send();
-			update_temperature(temperature_format);
-        }
-    }
-    
+    PROFILE_TIMER_START(tick_start);
+
+    run_tick_pipeline(tick_time, units_changed);
+
+    // Refresh the weather when it is stale and the phone is reachable
+    weather_tick(tick_time);
+
     if( (units_changed & DAY_UNIT) != 0){
-        update_image();
-        layer_mark_dirty(bitmap_layer_get_layer(s_background_layer));
+        PROFILE_LOG("Redraws: time %d, date %d, panel %d, weather %d, battery %d",
+            (int)render_get_redraws(RENDER_TIME), (int)render_get_redraws(RENDER_DATE),
+            (int)render_get_redraws(RENDER_PANEL), (int)render_get_redraws(RENDER_WEATHER),
+            (int)render_get_redraws(RENDER_BATTERY));
+
+#ifdef FESTIVE_PROFILE
+        WeatherStats stats;
+        weather_get_stats(&stats);
+        PROFILE_LOG("Weather: %d requests, %d retries, %d failures, %d wakeups saved",
+            (int)stats.requests, (int)stats.retries, (int)stats.failures, (int)stats.wakeups_saved);
+#endif
     }        
+
+    PROFILE_TICK_DONE(tick_start);
+}
+
+/** Weather interval from the settings, stretched by the power tier **/
+static void apply_weather_interval(void){
+    weather_set_freshness(s_settings.weather_interval * power_policy()->weather_stretch);
+}
+
+/** Power tiers start where the settings say, moving the face if the battery is past one now **/
+static void apply_power_thresholds(void){
+    if(power_set_thresholds(s_settings.power_saver, s_settings.power_critical, battery_state_service_peek()))
+        apply_power_policy();
+}
+
+/** Brings the face in line with a new power tier **/
+static void apply_power_policy(void){
+    apply_weather_interval();
+
+    // Back from a plain frame, or catch up on the minutes the weather waited
+    if(power_policy()->swap_background && s_background_bitmap == NULL && s_panel_layer != NULL)
+        update_image();
+    if(!power_policy()->minute_only)
+        update_temperature();
+}
+
+/** Picks the colors for the normal or inverted theme **/
+static void set_inverted(bool inverted){
+	s_settings.inverted = inverted;
+	if(inverted){
+		background_color = WHITE;
+		foreground_color = BLACK;
+	}else{
+		background_color = BLACK;
+		foreground_color = WHITE;
+	}
+}
+
+/** Applies the theme colors to the existing layers **/
+static void apply_theme(void){
+    GColor background = background_color ? GColorWhite : GColorBlack;
+    GColor foreground = foreground_color ? GColorWhite : GColorBlack;
+
+    window_set_background_color(window, background);
+    panel_set_inverted(s_settings.inverted);
+
+    text_layer_set_text_color(s_time_layer, foreground);
+    text_layer_set_text_color(s_date_layer, foreground);
+    text_layer_set_text_color(s_weather_layer, foreground);
+
+    // Custom layers read the colors when they draw
+    render_invalidate(RENDER_BATTERY);
+    render_invalidate(RENDER_DIVIDER);
 }
 
 /** Create elements in window **/
 static void window_load(Window *window) {
     Layer *window_layer = window_get_root_layer(window);
 
-	// check for color inversion
-	if(persist_exists(KEY_INVERT_COLOR)){
-		is_inverted = persist_read_bool(KEY_INVERT_COLOR);
-		if(is_inverted){
-			background_color = WHITE;
-			foreground_color = BLACK;
-		}else{
-			background_color = BLACK;
-			foreground_color = WHITE;
-		}
-	}
+    PROFILE_HEAP_START(fonts);
+    GFont time_font = fonts_get_system_font(FONT_KEY_BITHAM_42_LIGHT);
+    GFont text_font = fonts_get_system_font(FONT_KEY_GOTHIC_24);
+    PROFILE_HEAP_CLAIMED(PROFILE_HEAP_FONTS, fonts);
 
-    window_set_background_color(window, background_color ? GColorWhite : GColorBlack);
+    PROFILE_HEAP_START(layers);
 
-    // Create GBitmap, then set to created BitmapLayer
-    s_background_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_CAMEL);
-    s_background_layer = bitmap_layer_create(GRect(0, 0, 144, 88));
-    bitmap_layer_set_bitmap(s_background_layer, s_background_bitmap);
-	bitmap_layer_set_compositing_mode(s_background_layer, GCompOpAssign);
-	if(is_inverted)
-		bitmap_layer_set_compositing_mode(s_background_layer, GCompOpAssignInverted);
-    layer_add_child(window_layer, bitmap_layer_get_layer(s_background_layer));
+    // Create the upper panel, the day stage sets the day's bitmap and banner
+    s_panel_layer = panel_create(GRect(0, 0, 144, 88));
+    s_bt_connected = bluetooth_connection_service_peek();
+    panel_set_bt_visible(!s_bt_connected);
+    layer_add_child(window_layer, s_panel_layer);
 
     // Create time TextLayer
     s_time_layer = text_layer_create(GRect(0, 85, 144, 50));
     text_layer_set_text_alignment(s_time_layer, GTextAlignmentCenter);
     text_layer_set_background_color(s_time_layer, GColorClear);
-    text_layer_set_text_color(s_time_layer, foreground_color ? GColorWhite : GColorBlack);
-    text_layer_set_font(s_time_layer, fonts_get_system_font(FONT_KEY_BITHAM_42_LIGHT));
+    text_layer_set_font(s_time_layer, time_font);
 
     // Create date TextLayer
     s_date_layer = text_layer_create(GRect(0, 135, 90, 50));
     text_layer_set_text_alignment(s_date_layer, GTextAlignmentCenter);
     text_layer_set_background_color(s_date_layer, GColorClear);
-    text_layer_set_text_color(s_date_layer, foreground_color ? GColorWhite : GColorBlack);
-    text_layer_set_font(s_date_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24));
-
-    // Create weekday TextLayer
-    s_weekday_layer = text_layer_create(GRect(2, 52, 140, 20));
-    text_layer_set_text_alignment(s_weekday_layer, GTextAlignmentCenter);
-    text_layer_set_background_color(s_weekday_layer, GColorBlack);
-    text_layer_set_text_color(s_weekday_layer, foreground_color ? GColorWhite : GColorBlack);
-    text_layer_set_font(s_weekday_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
-    
+    text_layer_set_font(s_date_layer, text_font);
+
     // Create battery layer
     s_battery_layer = layer_create(GRect(10, 135, 123, 3));
     layer_set_update_proc(s_battery_layer, battery_update_proc);
@@ -475,79 +434,70 @@ static void window_load(Window *window) {
     s_divider_layer = layer_create(GRect(90, 141, 1, 24));
     layer_set_update_proc(s_divider_layer, divider_update_proc);
     
-    // Create the Bluetooth layer
-    s_bt_icon_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BT_ICON);
-    s_bt_icon_layer = bitmap_layer_create(GRect(59, 12, 30, 30));
-    bitmap_layer_set_bitmap(s_bt_icon_layer, s_bt_icon_bitmap);
-	bitmap_layer_set_compositing_mode(s_bt_icon_layer, GCompOpAssign);
-	if(is_inverted)
-		bitmap_layer_set_compositing_mode(s_bt_icon_layer, GCompOpAssignInverted);	
-    bluetooth_callback(bluetooth_connection_service_peek());
-    
     // Create temperature layer
     s_weather_layer = text_layer_create(GRect(90, 135, 59, 50));
     text_layer_set_background_color(s_weather_layer, GColorClear);
-    text_layer_set_text_color(s_weather_layer, foreground_color ? GColorWhite : GColorBlack);
     text_layer_set_text_alignment(s_weather_layer, GTextAlignmentCenter);
-    text_layer_set_font(s_weather_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24));
-	text_layer_set_text(s_weather_layer, "...");
+    text_layer_set_font(s_weather_layer, text_font);
 
     // Add layers to window
     layer_add_child(window_layer, text_layer_get_layer(s_time_layer));
     layer_add_child(window_layer, text_layer_get_layer(s_date_layer));
-    layer_add_child(window_layer, text_layer_get_layer(s_weekday_layer));
     layer_add_child(window_layer, s_battery_layer);
     layer_add_child(window_layer, s_divider_layer);
-    layer_add_child(window_layer, bitmap_layer_get_layer(s_bt_icon_layer));
     layer_add_child(window_layer, text_layer_get_layer(s_weather_layer));
-
-	/* Check persist items */
-	if(persist_exists(KEY_TWENTY_FOUR_HOUR_FORMAT)){
-		twenty_four_hour_format = persist_read_bool(KEY_TWENTY_FOUR_HOUR_FORMAT);
-		update_time();
-		APP_LOG(APP_LOG_LEVEL_DEBUG, "Time: [%s]", (twenty_four_hour_format) ? "24 hours" : "12 hours");	
-	}
-
-	if(persist_exists(KEY_BATTERY_ON_OFF)){
-		battery_on_off = persist_read_bool(KEY_BATTERY_ON_OFF);
-		layer_mark_dirty(s_battery_layer);
-
-		APP_LOG(APP_LOG_LEVEL_DEBUG, "Battery: [%s]", (battery_on_off) ? "On" : "Off");	
-	}
-
-	if(persist_exists(KEY_TEMP_TYPE)){
-		persist_read_string(KEY_TEMP_TYPE, temperature_format, sizeof("Fahrenheit"));
-		update_temperature(temperature_format);
-		APP_LOG(APP_LOG_LEVEL_DEBUG, "Temp style: [%s]", temperature_format);
-	}
-
-	if(persist_exists(KEY_BDAY_LIST_SIZE)){
-		birthday_list_size = persist_read_int(KEY_BDAY_LIST_SIZE);
-		APP_LOG(APP_LOG_LEVEL_DEBUG, "Bday List Size: [%i]", birthday_list_size);
-	}
-
-	if(persist_exists(KEY_BIRTHDAY_LIST)){
-		persist_read_string(KEY_BIRTHDAY_LIST, birthday_list, birthday_list_size);
-		parse_birthday_list(birthday_list);
-	}
+    apply_theme();
+
+    // Hand the layers to the render scheduler
+    render_add_text_layer(RENDER_TIME, s_time_layer);
+    render_add_text_layer(RENDER_DATE, s_date_layer);
+    render_add_text_layer(RENDER_WEATHER, s_weather_layer);
+    render_add_layer(RENDER_BATTERY, s_battery_layer);
+    render_add_layer(RENDER_DIVIDER, s_divider_layer);
+    render_add_layer(RENDER_PANEL, s_panel_layer);
+    PROFILE_HEAP_CLAIMED(PROFILE_HEAP_LAYERS, layers);
+
+    // One full render once everything is in place, every stage runs on the first tick
+    time_t now = time(NULL);
+    s_tick.valid = false;
+    PROFILE_HEAP_START(bitmaps);
+    run_tick_pipeline(localtime(&now), 0);
+    PROFILE_HEAP_CLAIMED(PROFILE_HEAP_BITMAPS, bitmaps);
 }
 
 /** Free up the memory on delete **/
 static void window_unload(Window *window) {
+    render_remove_all();
     text_layer_destroy(s_time_layer);
     text_layer_destroy(s_date_layer);
-    text_layer_destroy(s_weekday_layer);
-    gbitmap_destroy(s_background_bitmap);
-    bitmap_layer_destroy(s_background_layer);
+    bitmap_cache_flush();
+    s_background_bitmap = NULL;
+    panel_destroy();
+    s_panel_layer = NULL;
     layer_destroy(s_battery_layer);
-    gbitmap_destroy(s_bt_icon_bitmap);
-    bitmap_layer_destroy(s_bt_icon_layer);
     text_layer_destroy(s_weather_layer);
     layer_destroy(s_divider_layer);
 }
 
+/** Tell the phone which config version is applied, again once the outbox is free if it is busy **/
+static void confirm_config(void){
+    if(s_config_owed == 0)
+        return;
+
+    DictionaryIterator *iter;
+    if(app_message_outbox_begin(&iter) != APP_MSG_OK)
+        return;
+    dict_write_int32(iter, KEY_CONFIG_VERSION, s_config_owed);
+    if(app_message_outbox_send() == APP_MSG_OK)
+        s_config_owed = 0;
+}
+
 /** JS AppMessages **/
 static void inbox_received_callback(DictionaryIterator *iterator, void *context){
+	bool settings_changed = false;
+	bool thresholds_changed = false;
+	PROFILE_MESSAGE(PROFILE_BYTES_IN, iterator);
+	PROFILE_TRACE_REPLY(iterator);
 
 	// Read first item
     Tuple *t = dict_read_first(iterator);
@@ -556,45 +506,75 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
     while(t != NULL) {
         switch(t->key){
             case KEY_TEMPERATURE:
-                initTemp = (int)t->value->int32;
-				update_temperature(temperature_format);
-                break;			
+            {
+                Tuple *observed = dict_find(iterator, KEY_WEATHER_TIME);
+                weather_received(t->value->int32, observed != NULL ? (time_t)observed->value->int32 : 0);
+				update_temperature();
+                break;
+            }
+			case KEY_WEATHER_TIME:
+				// Read along with KEY_TEMPERATURE
+				break;
+			case KEY_WEATHER_FORECAST:
+				weather_forecast_received(t->value->data, t->length);
+				update_temperature();
+				break;			
 			case KEY_TWENTY_FOUR_HOUR_FORMAT:
-				twenty_four_hour_format = (bool)t->value->int8;
-				persist_write_bool(KEY_TWENTY_FOUR_HOUR_FORMAT, twenty_four_hour_format);
+				s_settings.twenty_four_hour = (bool)t->value->int8;
+				settings_changed = true;
 				update_time();
 				break;
 			case KEY_BATTERY_ON_OFF:
-				battery_on_off = (bool)t->value->int8;
-				persist_write_bool(KEY_BATTERY_ON_OFF, battery_on_off);
-				layer_mark_dirty(s_battery_layer);
+				s_settings.battery_on = (bool)t->value->int8;
+				settings_changed = true;
+				render_invalidate(RENDER_BATTERY);
 				break;
 			case KEY_TEMP_TYPE:
-				strcpy(temperature_format, (char*)t->value);
-				persist_write_string(KEY_TEMP_TYPE, temperature_format);
-				update_temperature(temperature_format);
+				s_settings.temp_format = settings_parse_temp_format(t->value->cstring);
+				settings_changed = true;
+				update_temperature();
+				break;
+			case KEY_WEATHER_INTERVAL:
+				s_settings.weather_interval = (uint16_t)t->value->int32;
+				settings_changed = true;
+				apply_weather_interval();
+				break;
+			case KEY_POWER_SAVER:
+				s_settings.power_saver = (uint8_t)t->value->int32;
+				settings_changed = true;
+				thresholds_changed = true;
 				break;
-			case KEY_BIRTHDAY_LIST:
-			{
-				strcpy(birthday_list, (char*)t->value);
-				persist_write_string(KEY_BIRTHDAY_LIST, birthday_list);
-				persist_write_int(KEY_BDAY_LIST_SIZE, strlen((char*)t->value)+1);
-				parse_birthday_list(birthday_list); 
+			case KEY_POWER_CRITICAL:
+				s_settings.power_critical = (uint8_t)t->value->int32;
+				settings_changed = true;
+				thresholds_changed = true;
+				break;
+			case KEY_CONFIG_VERSION:
+				// Only the settings that changed come along with it
+				s_settings.config_version = (uint16_t)t->value->int32;
+				s_config_owed = s_settings.config_version;
+				settings_changed = true;
+				break;
+			case KEY_BIRTHDAY_DATA:
+				if(birthdays_decode_chunk(t->value->data, t->length))
+					refresh_day();
+				break;
+			case KEY_CALENDAR:
+				if(calendar_decode_chunk(t->value->data, t->length))
+					refresh_day();
+				break;
+			case KEY_DEBUG:
+				PROFILE_SEND();
+				break;
+			case KEY_TRACE:
+				// Echo of the weather request's trace id
 				break;
-			}
 			case KEY_INVERT_COLOR:
-				is_inverted = (bool)t->value->int8;
-				if(is_inverted){
-					background_color = WHITE;
-					foreground_color = BLACK;
-				}else{
-					background_color = BLACK;
-					foreground_color = WHITE;
-				}
-				persist_write_bool(KEY_INVERT_COLOR, is_inverted);
-				window_unload(window);
-				window_load(window);
-				update_image();
+				if((bool)t->value->int8 == s_settings.inverted)
+					break;
+				set_inverted((bool)t->value->int8);
+				settings_changed = true;
+				apply_theme();
 				break;
             default:
                 APP_LOG(APP_LOG_LEVEL_ERROR, "Key %d not recognized!", (int)t->key);
@@ -602,6 +582,18 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
         }
         t = dict_read_next(iterator);
     }
+
+    // Both thresholds are checked together, whichever came along
+    if(thresholds_changed)
+        apply_power_thresholds();
+
+    // Everything the message changed goes to flash once, and only if it differs
+    if(settings_changed)
+        settings_save(&s_settings);
+    journal_flush();
+    confirm_config();
+    calendar_request_resync();
+    PROFILE_TRACE_APPLIED();
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void *context) {
@@ -610,13 +602,49 @@ static void inbox_dropped_callback(AppMessageResult reason, void *context) {
 
 static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
     APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox send failed!");
+    weather_outbox_failed(iterator);
+    confirm_config();
+    calendar_request_resync();
+    PROFILE_TRACE_REPORT();
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
-    APP_LOG(APP_LOG_LEVEL_INFO, "Outbox send success!");
+    PROFILE_MESSAGE(PROFILE_BYTES_OUT, iterator);
+    PROFILE_LOG("Outbox send success!");
+    PROFILE_TRACE_SENT(iterator);
+    confirm_config();
+    calendar_request_resync();
+    PROFILE_TRACE_REPORT();
+}
+
+/** Loads the birthday index, moving an old comma separated list into it once **/
+static void load_birthdays(void){
+	if(!birthdays_load() && persist_exists(KEY_BIRTHDAY_LIST)){
+		char birthday_list[PERSIST_STRING_MAX_LENGTH];
+		persist_read_string(KEY_BIRTHDAY_LIST, birthday_list, sizeof(birthday_list));
+		PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+		birthdays_import_list(birthday_list);
+		persist_delete(KEY_BIRTHDAY_LIST);
+		persist_delete(KEY_BDAY_LIST_SIZE);
+	}
+	APP_LOG(APP_LOG_LEVEL_DEBUG, "Birthdays: [%i]", birthdays_count());
 }
 
-static void init() {
+static void init(void) {
+    PROFILE_TIMER_START(startup);
+
+    // Dates and banners in the watch's language
+    setlocale(LC_ALL, "");
+    string_table_init();
+
+    // Everything persisted is read before the first frame
+    settings_load(&s_settings);
+    power_set_thresholds(s_settings.power_saver, s_settings.power_critical, battery_state_service_peek());
+    set_inverted(s_settings.inverted);
+    load_birthdays();
+    weather_init(bluetooth_connection_service_peek());
+    apply_weather_interval();
+
     window = window_create();
     window_set_window_handlers(window, (WindowHandlers) {
         .load = window_load,
@@ -626,8 +654,6 @@ static void init() {
 
     // Register for time and date updates
     tick_timer_service_subscribe(MINUTE_UNIT | DAY_UNIT, tick_handler);
-    update_time();
-    update_image();
     
     // Register for battery level updates
     battery_state_service_subscribe(battery_callback);
@@ -643,11 +669,24 @@ static void init() {
     app_message_register_outbox_failed(outbox_failed_callback);
     app_message_register_outbox_sent(outbox_sent_callback);
     
-    // Open AppMessage
-    app_message_open(app_message_inbox_size_maximum(), app_message_outbox_size_maximum());
+    // Open AppMessage with buffers sized for the largest message each way
+    PROFILE_HEAP_START(app_message);
+    app_message_open(messages_inbox_size(), messages_outbox_size());
+    PROFILE_HEAP_CLAIMED(PROFILE_HEAP_APP_MESSAGE, app_message);
+    // The first tick ran before AppMessage was open
+    calendar_request_resync();
+
+    // Migrations staged while loading
+    journal_flush();
+
+    PROFILE_SAMPLE_HEAP();
+    PROFILE_HEAP_REPORT();
+    PROFILE_LOG("Startup took %d ms", (int)PROFILE_ELAPSED(startup));
 }
 
-static void deinit() {
+static void deinit(void) {
+	weather_deinit();
+	journal_flush();
 	window_destroy(window);
 	
 }
@@ -655,7 +694,7 @@ static void deinit() {
 int main(void) {
   init();
 
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Done initializing, pushed window: %p", window);
+  PROFILE_LOG("Done initializing, pushed window: %p", window);
 
   app_event_loop();
   deinit();
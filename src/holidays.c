@@ -0,0 +1,270 @@
+#include <pebble.h>
+#include <stdlib.h>
+#include "holidays.h"
+#include "string_table.h"
+#include "text.h"
+
+/** How a rule finds its anchor day **/
+typedef enum {
+    RULE_FIXED,        // month/day
+    RULE_NTH_WEEKDAY,  // nth weekday of a month, negative n counts from the end
+    RULE_EASTER,       // Easter Sunday
+    RULE_SEASON        // equinox or solstice, month picks which one
+} RuleType;
+
+/**
+ * A holiday as data. The image covers the anchor day plus the days in
+ * [from, to] around it, the banner is only shown on the anchor day.
+ * Rules listed first win when two of them claim the same day.
+ **/
+typedef struct {
+    uint8_t type;
+    uint8_t month;
+    int8_t day;
+    uint8_t weekday;
+    int8_t from;
+    int8_t to;
+    uint8_t image;
+    uint8_t banner;
+} HolidayRule;
+
+static const HolidayRule s_rules[] = {
+    // Single days
+    { RULE_FIXED,       1,  1, 0,  0, 0, HOLIDAY_IMAGE_NEW_YEARS,      BANNER_NEW_YEAR },
+    { RULE_FIXED,       2, 14, 0,  0, 0, HOLIDAY_IMAGE_VALENTINE,      BANNER_VALENTINE },
+    { RULE_FIXED,       3, 17, 0,  0, 0, HOLIDAY_IMAGE_ST_PATRICK,     BANNER_ST_PATRICK },
+    { RULE_FIXED,       4,  1, 0,  0, 0, HOLIDAY_IMAGE_APRIL_FOOLS,    BANNER_APRIL_FOOLS },
+    { RULE_FIXED,       5,  5, 0,  0, 0, HOLIDAY_IMAGE_CINCO_DE_MAYO,  BANNER_CINCO_DE_MAYO },
+    { RULE_FIXED,       7,  4, 0,  0, 0, HOLIDAY_IMAGE_FOURTH_OF_JULY, BANNER_FOURTH_OF_JULY },
+    { RULE_SEASON,      3,  0, 0,  0, 0, HOLIDAY_IMAGE_SPRING,         BANNER_SPRING },
+    { RULE_SEASON,      6,  0, 0,  0, 0, HOLIDAY_IMAGE_SUMMER,         BANNER_SUMMER },
+    { RULE_SEASON,      9,  0, 0,  0, 0, HOLIDAY_IMAGE_FALL,           BANNER_FALL },
+
+    // Date ranges leading up to or around a holiday
+    { RULE_EASTER,      0,  0, 0, -6, 0, HOLIDAY_IMAGE_EASTER,         BANNER_EASTER },
+    { RULE_FIXED,      10, 31, 0, -6, 0, HOLIDAY_IMAGE_HALLOWEEN,      BANNER_HALLOWEEN },
+    { RULE_NTH_WEEKDAY,11,  4, 4, -3, 3, HOLIDAY_IMAGE_THANKSGIVING,   BANNER_THANKSGIVING },
+    { RULE_SEASON,     12,  0, 0, -4, 0, HOLIDAY_IMAGE_WINTER,         BANNER_WINTER },
+    { RULE_FIXED,      12, 25, 0, -2, 6, HOLIDAY_IMAGE_CHRISTMAS,      BANNER_CHRISTMAS },
+};
+
+static const uint32_t s_image_resources[HOLIDAY_IMAGE_COUNT] = {
+    [HOLIDAY_IMAGE_NONE]           = 0,
+    [HOLIDAY_IMAGE_NEW_YEARS]      = RESOURCE_ID_IMAGE_NEW_YEARS,
+    [HOLIDAY_IMAGE_VALENTINE]      = RESOURCE_ID_IMAGE_VALENTINE,
+    [HOLIDAY_IMAGE_ST_PATRICK]     = RESOURCE_ID_IMAGE_ST_PATRICK,
+    [HOLIDAY_IMAGE_SPRING]         = RESOURCE_ID_IMAGE_SPRING,
+    [HOLIDAY_IMAGE_APRIL_FOOLS]    = RESOURCE_ID_IMAGE_APRIL_FOOLS,
+    [HOLIDAY_IMAGE_EASTER]         = RESOURCE_ID_IMAGE_RABBIT,
+    [HOLIDAY_IMAGE_CINCO_DE_MAYO]  = RESOURCE_ID_IMAGE_CINCO_DE_MAYO,
+    [HOLIDAY_IMAGE_SUMMER]         = RESOURCE_ID_IMAGE_SUMMER,
+    [HOLIDAY_IMAGE_FOURTH_OF_JULY] = RESOURCE_ID_IMAGE_FOURTH_OF_JULY,
+    [HOLIDAY_IMAGE_FALL]           = RESOURCE_ID_IMAGE_FALL,
+    [HOLIDAY_IMAGE_HALLOWEEN]      = RESOURCE_ID_IMAGE_10_31,
+    [HOLIDAY_IMAGE_THANKSGIVING]   = RESOURCE_ID_IMAGE_TURKEY,
+    [HOLIDAY_IMAGE_WINTER]         = RESOURCE_ID_IMAGE_WINTER,
+    [HOLIDAY_IMAGE_CHRISTMAS]      = RESOURCE_ID_IMAGE_12_25,
+    [HOLIDAY_IMAGE_BIRTHDAY]       = RESOURCE_ID_IMAGE_BIRTHDAY,
+    [HOLIDAY_IMAGE_SUNDAY]         = RESOURCE_ID_IMAGE_SUNDAY,
+    [HOLIDAY_IMAGE_MONDAY]         = RESOURCE_ID_IMAGE_MONDAY,
+    [HOLIDAY_IMAGE_TUESDAY]        = RESOURCE_ID_IMAGE_TUESDAY,
+    [HOLIDAY_IMAGE_WEDNESDAY]      = RESOURCE_ID_IMAGE_CAMEL,
+    [HOLIDAY_IMAGE_THURSDAY]       = RESOURCE_ID_IMAGE_THURSDAY,
+    [HOLIDAY_IMAGE_FRIDAY]         = RESOURCE_ID_IMAGE_FRIDAY,
+    [HOLIDAY_IMAGE_SATURDAY]       = RESOURCE_ID_IMAGE_SATURDAY,
+};
+
+static HolidayDay s_table[HOLIDAY_TABLE_DAYS];
+static int s_table_year = 0;
+static bool s_from_phone;
+
+static bool is_leap_year(int year){
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+/** Day of the year (0 based) for a month (1-12) and day **/
+static int day_of_year(int year, int month, int day){
+    static const int16_t month_start[] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+    int yday = month_start[month - 1] + day - 1;
+    if(month > 2 && is_leap_year(year))
+        yday++;
+    return yday;
+}
+
+/** Days since 1970-01-01 for a civil date **/
+static int32_t days_from_civil(int year, int month, int day){
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    int32_t yoe = year - era * 400;
+    int32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/** Weekday (0 = Sunday) for a civil date **/
+static int weekday_of(int year, int month, int day){
+    int32_t days = days_from_civil(year, month, day);
+    return (int)((days % 7 + 11) % 7);
+}
+
+static int days_in_month(int year, int month){
+    static const uint8_t lengths[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if(month == 2 && is_leap_year(year))
+        return 29;
+    return lengths[month - 1];
+}
+
+/** Easter Sunday, anonymous Gregorian computus **/
+static int easter_yday(int year){
+    int a = year % 19;
+    int b = year / 100;
+    int c = year % 100;
+    int d = b / 4;
+    int e = b % 4;
+    int f = (b + 8) / 25;
+    int g = (b - f + 1) / 3;
+    int h = (19 * a + b - d - g + 15) % 30;
+    int i = c / 4;
+    int k = c % 4;
+    int l = (32 + 2 * e + 2 * i - h - k) % 7;
+    int m = (a + 11 * h + 22 * l) / 451;
+    int month = (h + l - 7 * m + 114) / 31;
+    int day = (h + l - 7 * m + 114) % 31 + 1;
+    return day_of_year(year, month, day);
+}
+
+/** Equinox or solstice day (UTC) from Meeus' mean season formulas **/
+static int season_yday(int year, int month){
+    double y = (year - 2000) / 1000.0;
+    double jde;
+    switch(month){
+        case 3:
+            jde = 2451623.80984 + 365242.37404 * y + 0.05169 * y * y - 0.00411 * y * y * y - 0.00057 * y * y * y * y;
+            break;
+        case 6:
+            jde = 2451716.56767 + 365241.62603 * y + 0.00325 * y * y + 0.00888 * y * y * y - 0.00030 * y * y * y * y;
+            break;
+        case 9:
+            jde = 2451810.21715 + 365242.01767 * y - 0.11575 * y * y + 0.00337 * y * y * y + 0.00078 * y * y * y * y;
+            break;
+        default:
+            jde = 2451900.05952 + 365242.74049 * y - 0.06223 * y * y - 0.00823 * y * y * y + 0.00032 * y * y * y * y;
+            break;
+    }
+    double year_start = days_from_civil(year, 1, 1) + 2440587.5;
+    return (int)(jde - year_start);
+}
+
+/** Anchor day of a rule for a year, -1 if it doesn't resolve **/
+static int rule_anchor(const HolidayRule *rule, int year){
+    switch(rule->type){
+        case RULE_FIXED:
+            if(rule->day > days_in_month(year, rule->month))
+                return -1;
+            return day_of_year(year, rule->month, rule->day);
+        case RULE_NTH_WEEKDAY:
+        {
+            int day;
+            if(rule->day > 0){
+                int first = weekday_of(year, rule->month, 1);
+                day = 1 + (rule->weekday - first + 7) % 7 + (rule->day - 1) * 7;
+            }else{
+                int last_day = days_in_month(year, rule->month);
+                int last = weekday_of(year, rule->month, last_day);
+                day = last_day - (last - rule->weekday + 7) % 7 + (rule->day + 1) * 7;
+            }
+            if(day < 1 || day > days_in_month(year, rule->month))
+                return -1;
+            return day_of_year(year, rule->month, day);
+        }
+        case RULE_EASTER:
+            return easter_yday(year) + rule->day;
+        case RULE_SEASON:
+            return season_yday(year, rule->month) + rule->day;
+        default:
+            return -1;
+    }
+}
+
+void holidays_compile(int year){
+    int days = is_leap_year(year) ? 366 : 365;
+    memset(s_table, 0, sizeof(s_table));
+
+    // Holidays, first rule to claim a day keeps it
+    for(unsigned int r = 0; r < ARRAY_LENGTH(s_rules); r++){
+        const HolidayRule *rule = &s_rules[r];
+        int anchor = rule_anchor(rule, year);
+        if(anchor < 0)
+            continue;
+
+        for(int offset = rule->from; offset <= rule->to; offset++){
+            int yday = anchor + offset;
+            if(yday < 0 || yday >= days || s_table[yday].image != HOLIDAY_IMAGE_NONE)
+                continue;
+            s_table[yday].image = rule->image;
+            s_table[yday].banner = offset == 0 ? rule->banner : BANNER_NONE;
+        }
+    }
+
+    // Everything else falls back to the weekday
+    int weekday = weekday_of(year, 1, 1);
+    for(int yday = 0; yday < days; yday++, weekday = (weekday + 1) % 7){
+        if(s_table[yday].image != HOLIDAY_IMAGE_NONE)
+            continue;
+        s_table[yday].image = HOLIDAY_IMAGE_SUNDAY + weekday;
+        if(s_table[yday].image == HOLIDAY_IMAGE_THURSDAY)
+            s_table[yday].banner = BANNER_THURSDAY_THOUGHTS;
+    }
+
+    s_table_year = year;
+    s_from_phone = false;
+}
+
+int holidays_year(void){
+    return s_table_year;
+}
+
+void holidays_set_days(int year, int first, const HolidayDay *days, int count){
+    if(year != s_table_year || !s_from_phone){
+        memset(s_table, 0, sizeof(s_table));
+        s_table_year = year;
+        s_from_phone = true;
+    }
+    if(first < 0 || first >= HOLIDAY_TABLE_DAYS)
+        return;
+    if(count > HOLIDAY_TABLE_DAYS - first)
+        count = HOLIDAY_TABLE_DAYS - first;
+    memcpy(&s_table[first], days, count * sizeof(HolidayDay));
+}
+
+bool holidays_from_phone(void){
+    return s_from_phone;
+}
+
+HolidayDay holidays_lookup(int yday){
+    if(yday < 0 || yday >= HOLIDAY_TABLE_DAYS)
+        return (HolidayDay){ HOLIDAY_IMAGE_NONE, BANNER_NONE };
+    return s_table[yday];
+}
+
+uint32_t holidays_image_resource(uint8_t image){
+    if(image >= HOLIDAY_IMAGE_COUNT)
+        return 0;
+    return s_image_resources[image];
+}
+
+bool holidays_is_event(uint8_t banner){
+    return banner >= BANNER_NEW_YEAR && banner <= BANNER_CHRISTMAS;
+}
+
+const char *holidays_banner_text(uint8_t banner){
+    if(banner == BANNER_NONE || banner >= BANNER_COUNT)
+        return NULL;
+
+    // Only today's string is read from the table
+    uint16_t id = STRING_BANNER(banner);
+    if(banner == BANNER_THURSDAY_THOUGHTS && string_table_thought_count() > 0)
+        id = STRING_THOUGHT(rand() % string_table_thought_count());
+    const char *text = string_table_get(id, text_buffer(TEXT_BANNER), text_size(TEXT_BANNER));
+    return text[0] != '\0' ? text : NULL;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <pebble.h>
+
+#define HOLIDAY_TABLE_DAYS 366
+
+/** Background images a day can resolve to **/
+typedef enum {
+    HOLIDAY_IMAGE_NONE = 0,
+    HOLIDAY_IMAGE_NEW_YEARS,
+    HOLIDAY_IMAGE_VALENTINE,
+    HOLIDAY_IMAGE_ST_PATRICK,
+    HOLIDAY_IMAGE_SPRING,
+    HOLIDAY_IMAGE_APRIL_FOOLS,
+    HOLIDAY_IMAGE_EASTER,
+    HOLIDAY_IMAGE_CINCO_DE_MAYO,
+    HOLIDAY_IMAGE_SUMMER,
+    HOLIDAY_IMAGE_FOURTH_OF_JULY,
+    HOLIDAY_IMAGE_FALL,
+    HOLIDAY_IMAGE_HALLOWEEN,
+    HOLIDAY_IMAGE_THANKSGIVING,
+    HOLIDAY_IMAGE_WINTER,
+    HOLIDAY_IMAGE_CHRISTMAS,
+    HOLIDAY_IMAGE_BIRTHDAY,
+    HOLIDAY_IMAGE_SUNDAY,
+    HOLIDAY_IMAGE_MONDAY,
+    HOLIDAY_IMAGE_TUESDAY,
+    HOLIDAY_IMAGE_WEDNESDAY,
+    HOLIDAY_IMAGE_THURSDAY,
+    HOLIDAY_IMAGE_FRIDAY,
+    HOLIDAY_IMAGE_SATURDAY,
+    HOLIDAY_IMAGE_COUNT
+} HolidayImage;
+
+/** Banner text shown over the background **/
+typedef enum {
+    BANNER_NONE = 0,
+    BANNER_NEW_YEAR,
+    BANNER_VALENTINE,
+    BANNER_ST_PATRICK,
+    BANNER_SPRING,
+    BANNER_APRIL_FOOLS,
+    BANNER_EASTER,
+    BANNER_CINCO_DE_MAYO,
+    BANNER_SUMMER,
+    BANNER_FOURTH_OF_JULY,
+    BANNER_FALL,
+    BANNER_HALLOWEEN,
+    BANNER_THANKSGIVING,
+    BANNER_WINTER,
+    BANNER_CHRISTMAS,
+    BANNER_THURSDAY_THOUGHTS,
+    // Text comes from the birthday index, only the phone's table uses it
+    BANNER_BIRTHDAY,
+    BANNER_COUNT
+} HolidayBanner;
+
+/** One packed entry of the compiled year table **/
+typedef struct {
+    uint8_t image;
+    uint8_t banner;
+} HolidayDay;
+
+/** Compile the holiday rules for a year into the day table **/
+void holidays_compile(int year);
+
+/** Year the day table was last compiled or received for, 0 if never **/
+int holidays_year(void);
+
+/** Overwrite days of the table with ones computed by the phone, switching it to that year **/
+void holidays_set_days(int year, int first, const HolidayDay *days, int count);
+
+/** Whether the table came from the phone rather than the built-in rules **/
+bool holidays_from_phone(void);
+
+/** Look up a day of the year (tm_yday) in the compiled table **/
+HolidayDay holidays_lookup(int yday);
+
+/** Resource id for an image, 0 if the day has no image **/
+uint32_t holidays_image_resource(uint8_t image);
+
+/** Whether a banner marks a holiday worth a countdown, Thursday Thoughts and birthdays don't **/
+bool holidays_is_event(uint8_t banner);
+
+/** Text for a banner in the watch's language, NULL if the day has no banner **/
+const char *holidays_banner_text(uint8_t banner);
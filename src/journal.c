@@ -0,0 +1,64 @@
+#include <pebble.h>
+#include "journal.h"
+#include "profile.h"
+
+// Enough for the settings and the weather at once, the birthday index writes its keys itself
+#define JOURNAL_SLOTS 8
+
+typedef struct {
+    uint32_t key;
+    const void *data;
+    uint16_t size;
+} JournalEntry;
+
+static JournalEntry s_entries[JOURNAL_SLOTS];
+static int s_count;
+
+/** Whether the key already holds exactly these bytes **/
+static bool unchanged(uint32_t key, const void *data, size_t size){
+    uint8_t stored[PERSIST_DATA_MAX_LENGTH];
+    if(size > sizeof(stored))
+        return false;
+    PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+    return persist_read_data(key, stored, sizeof(stored)) == (int)size && memcmp(stored, data, size) == 0;
+}
+
+bool journal_write(uint32_t key, const void *data, size_t size){
+    if(unchanged(key, data, size)){
+        PROFILE_COUNT(PROFILE_PERSIST_AVOIDED, 1);
+        return true;
+    }
+    int written = persist_write_data(key, data, size);
+    PROFILE_COUNT(PROFILE_PERSIST_WRITES, 1);
+    if(written != (int)size){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Persist write of key %d failed: %d", (int)key, written);
+        return false;
+    }
+    return true;
+}
+
+void journal_mark(uint32_t key, const void *data, size_t size){
+    for(int i = 0; i < s_count; i++){
+        if(s_entries[i].key == key){
+            s_entries[i].data = data;
+            s_entries[i].size = size;
+            return;
+        }
+    }
+
+    if(s_count == JOURNAL_SLOTS)
+        journal_flush();
+    s_entries[s_count++] = (JournalEntry){
+        .key = key,
+        .data = data,
+        .size = size,
+    };
+}
+
+bool journal_flush(void){
+    bool written = true;
+    for(int i = 0; i < s_count; i++)
+        written &= journal_write(s_entries[i].key, s_entries[i].data, s_entries[i].size);
+    s_count = 0;
+    return written;
+}
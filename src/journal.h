@@ -0,0 +1,16 @@
+#pragma once
+
+#include <pebble.h>
+
+/**
+ * Stage a persist write until the next journal_flush(). The data is read at
+ * flush time, so it has to stay where it is until then; marking a key again
+ * replaces what was staged for it.
+ **/
+void journal_mark(uint32_t key, const void *data, size_t size);
+
+/** Write everything staged, skipping keys that already hold the same bytes. False if a write failed **/
+bool journal_flush(void);
+
+/** Write one key right away, unless it already holds the same bytes. False if the write failed **/
+bool journal_write(uint32_t key, const void *data, size_t size);
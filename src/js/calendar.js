@@ -0,0 +1,236 @@
+// Day table for the watch, see calendar_decode_chunk() on the watch
+var CALENDAR_FORMAT_VERSION = 1;
+var CALENDAR_CHUNK_FULL = 0x01;
+var CALENDAR_CHUNK_LAST = 0x02;
+// The watch sizes its inbox for this, see CALENDAR_MESSAGE_MAX
+var CALENDAR_CHUNK_DAYS = 96;
+var CALENDAR_TABLE_DAYS = 366;
+// Changed days closer than this are sent as one run
+var CALENDAR_DELTA_GAP = 4;
+// Last table the watch acknowledged
+var CALENDAR_SENT_KEY = 'calendarSent';
+var BIRTHDAY_LIST_KEY = 'birthdayList';
+
+// Same numbering as HolidayImage and HolidayBanner in holidays.h
+var IMAGE = {
+  NONE: 0, NEW_YEARS: 1, VALENTINE: 2, ST_PATRICK: 3, SPRING: 4, APRIL_FOOLS: 5,
+  EASTER: 6, CINCO_DE_MAYO: 7, SUMMER: 8, FOURTH_OF_JULY: 9, FALL: 10,
+  HALLOWEEN: 11, THANKSGIVING: 12, WINTER: 13, CHRISTMAS: 14, BIRTHDAY: 15,
+  SUNDAY: 16
+};
+var BANNER = {
+  NONE: 0, NEW_YEAR: 1, VALENTINE: 2, ST_PATRICK: 3, SPRING: 4, APRIL_FOOLS: 5,
+  EASTER: 6, CINCO_DE_MAYO: 7, SUMMER: 8, FOURTH_OF_JULY: 9, FALL: 10,
+  HALLOWEEN: 11, THANKSGIVING: 12, WINTER: 13, CHRISTMAS: 14,
+  THURSDAY_THOUGHTS: 15, BIRTHDAY: 16
+};
+
+/*
+ * Holiday rules, the first rule to claim a day keeps it. Days from..to
+ * around the anchor show the image, the banner only on the anchor itself.
+ * Rules with regions only apply to those countries.
+ */
+var HOLIDAY_RULES = [
+  // Single days
+  { type: 'fixed', month: 1, day: 1, image: IMAGE.NEW_YEARS, banner: BANNER.NEW_YEAR },
+  { type: 'fixed', month: 2, day: 14, image: IMAGE.VALENTINE, banner: BANNER.VALENTINE },
+  { type: 'fixed', month: 3, day: 17, image: IMAGE.ST_PATRICK, banner: BANNER.ST_PATRICK },
+  { type: 'fixed', month: 4, day: 1, image: IMAGE.APRIL_FOOLS, banner: BANNER.APRIL_FOOLS },
+  { type: 'fixed', month: 5, day: 5, image: IMAGE.CINCO_DE_MAYO, banner: BANNER.CINCO_DE_MAYO, regions: ['US', 'MX'] },
+  { type: 'fixed', month: 7, day: 4, image: IMAGE.FOURTH_OF_JULY, banner: BANNER.FOURTH_OF_JULY, regions: ['US'] },
+  { type: 'season', month: 3, image: IMAGE.SPRING, banner: BANNER.SPRING },
+  { type: 'season', month: 6, image: IMAGE.SUMMER, banner: BANNER.SUMMER },
+  { type: 'season', month: 9, image: IMAGE.FALL, banner: BANNER.FALL },
+
+  // Date ranges leading up to or around a holiday
+  { type: 'easter', from: -6, image: IMAGE.EASTER, banner: BANNER.EASTER },
+  { type: 'fixed', month: 10, day: 31, from: -6, image: IMAGE.HALLOWEEN, banner: BANNER.HALLOWEEN },
+  { type: 'weekday', month: 11, nth: 4, weekday: 4, from: -3, to: 3, image: IMAGE.THANKSGIVING, banner: BANNER.THANKSGIVING, regions: ['US'] },
+  { type: 'weekday', month: 10, nth: 2, weekday: 1, from: -3, to: 0, image: IMAGE.THANKSGIVING, banner: BANNER.THANKSGIVING, regions: ['CA'] },
+  { type: 'season', month: 12, from: -4, image: IMAGE.WINTER, banner: BANNER.WINTER },
+  { type: 'fixed', month: 12, day: 25, from: -2, to: 6, image: IMAGE.CHRISTMAS, banner: BANNER.CHRISTMAS }
+];
+
+function isLeapYear(year) {
+  return (year % 4 === 0 && year % 100 !== 0) || year % 400 === 0;
+}
+
+/** Day of the year (0 based) for a month (1-12) and day **/
+function dayOfYear(year, month, day) {
+  return Math.round((Date.UTC(year, month - 1, day) - Date.UTC(year, 0, 1)) / 86400000);
+}
+
+function daysInMonth(year, month) {
+  return new Date(Date.UTC(year, month, 0)).getUTCDate();
+}
+
+/** Easter Sunday, anonymous Gregorian computus **/
+function easterDay(year) {
+  var a = year % 19, b = Math.floor(year / 100), c = year % 100;
+  var d = Math.floor(b / 4), e = b % 4, f = Math.floor((b + 8) / 25);
+  var g = Math.floor((b - f + 1) / 3);
+  var h = (19 * a + b - d - g + 15) % 30;
+  var i = Math.floor(c / 4), k = c % 4;
+  var l = (32 + 2 * e + 2 * i - h - k) % 7;
+  var m = Math.floor((a + 11 * h + 22 * l) / 451);
+  var month = Math.floor((h + l - 7 * m + 114) / 31);
+  var day = (h + l - 7 * m + 114) % 31 + 1;
+  return dayOfYear(year, month, day);
+}
+
+/** Equinox or solstice day (UTC) from Meeus' mean season formulas **/
+function seasonDay(year, month) {
+  var y = (year - 2000) / 1000;
+  var terms = {
+    3: [2451623.80984, 365242.37404, 0.05169, -0.00411, -0.00057],
+    6: [2451716.56767, 365241.62603, 0.00325, 0.00888, -0.00030],
+    9: [2451810.21715, 365242.01767, -0.11575, 0.00337, 0.00078],
+    12: [2451900.05952, 365242.74049, -0.06223, -0.00823, 0.00032]
+  }[month];
+  var jde = terms[0] + y * (terms[1] + y * (terms[2] + y * (terms[3] + y * terms[4])));
+  var yearStart = Date.UTC(year, 0, 1) / 86400000 + 2440587.5;
+  return Math.floor(jde - yearStart);
+}
+
+/** Anchor day of a rule for a year, -1 if it doesn't resolve **/
+function ruleAnchor(rule, year) {
+  switch(rule.type){
+    case 'fixed':
+      return rule.day <= daysInMonth(year, rule.month) ? dayOfYear(year, rule.month, rule.day) : -1;
+    case 'weekday':
+      var first = new Date(Date.UTC(year, rule.month - 1, 1)).getUTCDay();
+      var day = 1 + (rule.weekday - first + 7) % 7 + (rule.nth - 1) * 7;
+      return day <= daysInMonth(year, rule.month) ? dayOfYear(year, rule.month, day) : -1;
+    case 'easter':
+      return easterDay(year);
+    case 'season':
+      return seasonDay(year, rule.month);
+  }
+  return -1;
+}
+
+/** Country of the phone's locale, the face's holidays are US ones without it **/
+function calendarRegion() {
+  var match = /[-_]([A-Za-z]{2})\b/.exec(navigator.language || '');
+  return match ? match[1].toUpperCase() : 'US';
+}
+
+/** Birthdays from "Name,MM/DD,Name,MM/DD" as { month, day } **/
+function parseBirthdays(list) {
+  var fields = list ? list.split(',') : [];
+  var birthdays = [];
+  for(var i = 0; i + 1 < fields.length; i += 2){
+    var date = fields[i + 1].split('/');
+    var month = parseInt(date[0], 10);
+    var day = parseInt(date[1], 10);
+    if(month >= 1 && month <= 12 && day >= 1 && day <= 31)
+      birthdays.push({ month: month, day: day });
+  }
+  return birthdays;
+}
+
+/** The year as [image, banner] pairs for 366 days, flattened **/
+function computeCalendar(year, birthdayList, region) {
+  var days = isLeapYear(year) ? 366 : 365;
+  var table = [];
+  for(var i = 0; i < CALENDAR_TABLE_DAYS * 2; i++)
+    table.push(0);
+
+  // Birthdays first, the watch shows them over any holiday
+  parseBirthdays(birthdayList).forEach(function(birthday) {
+    if(birthday.day > daysInMonth(year, birthday.month))
+      return;
+    var yday = dayOfYear(year, birthday.month, birthday.day);
+    table[yday * 2] = IMAGE.BIRTHDAY;
+    table[yday * 2 + 1] = BANNER.BIRTHDAY;
+  });
+
+  HOLIDAY_RULES.forEach(function(rule) {
+    if(rule.regions && rule.regions.indexOf(region) < 0)
+      return;
+    var anchor = ruleAnchor(rule, year);
+    if(anchor < 0)
+      return;
+    for(var offset = rule.from || 0; offset <= (rule.to || 0); offset++){
+      var yday = anchor + offset;
+      if(yday < 0 || yday >= days || table[yday * 2] !== IMAGE.NONE)
+        continue;
+      table[yday * 2] = rule.image;
+      table[yday * 2 + 1] = offset === 0 ? rule.banner : BANNER.NONE;
+    }
+  });
+
+  // Everything else falls back to the weekday
+  var weekday = new Date(Date.UTC(year, 0, 1)).getUTCDay();
+  for(var yday = 0; yday < days; yday++, weekday = (weekday + 1) % 7){
+    if(table[yday * 2] !== IMAGE.NONE)
+      continue;
+    table[yday * 2] = IMAGE.SUNDAY + weekday;
+    table[yday * 2 + 1] = weekday === 4 ? BANNER.THURSDAY_THOUGHTS : BANNER.NONE;
+  }
+  return table;
+}
+
+function calendarChunk(year, flags, first, count, table) {
+  return [CALENDAR_FORMAT_VERSION, flags, year & 0xff, year >> 8, first & 0xff, first >> 8, count]
+    .concat(table.slice(first * 2, (first + count) * 2));
+}
+
+/** Chunks for the whole year, or only the runs of days that differ from the last sent table **/
+function encodeCalendar(year, table, previous) {
+  var chunks = [];
+  if(previous === null || previous.year !== year){
+    for(var first = 0; first < CALENDAR_TABLE_DAYS; first += CALENDAR_CHUNK_DAYS){
+      var count = Math.min(CALENDAR_CHUNK_DAYS, CALENDAR_TABLE_DAYS - first);
+      var flags = CALENDAR_CHUNK_FULL | (first + count >= CALENDAR_TABLE_DAYS ? CALENDAR_CHUNK_LAST : 0);
+      chunks.push(calendarChunk(year, flags, first, count, table));
+    }
+    return chunks;
+  }
+
+  var start = -1, last = -1;
+  for(var day = 0; day <= CALENDAR_TABLE_DAYS; day++){
+    var changed = day < CALENDAR_TABLE_DAYS &&
+      (table[day * 2] !== previous.days[day * 2] || table[day * 2 + 1] !== previous.days[day * 2 + 1]);
+    if(changed){
+      if(start < 0)
+        start = day;
+      last = day;
+    }
+    if(start >= 0 && (day === CALENDAR_TABLE_DAYS || day - last >= CALENDAR_DELTA_GAP ||
+                      last - start + 1 >= CALENDAR_CHUNK_DAYS)){
+      chunks.push(calendarChunk(year, 0, start, last - start + 1, table));
+      start = -1;
+    }
+  }
+  return chunks;
+}
+
+function readSentCalendar() {
+  try {
+    return JSON.parse(localStorage.getItem(CALENDAR_SENT_KEY));
+  } catch(e) {
+    return null;
+  }
+}
+
+/** Bring the watch's day table up to date with as little as possible, for this year unless one is given **/
+function updateCalendar(year) {
+  year = year || new Date().getFullYear();
+  var table = computeCalendar(year, localStorage.getItem(BIRTHDAY_LIST_KEY), calendarRegion());
+  var chunks = encodeCalendar(year, table, readSentCalendar());
+  if(chunks.length === 0)
+    return;
+
+  console.log('Sending calendar ' + year + ' in ' + chunks.length + ' chunks');
+  sendChunks('calendar', chunks, function() {
+    localStorage.setItem(CALENDAR_SENT_KEY, JSON.stringify({ year: year, days: table }));
+  });
+}
+
+/** The watch couldn't apply what it got and needs the whole table for a year **/
+function resyncCalendar(year) {
+  console.log('Watch asked for the whole calendar ' + year);
+  localStorage.removeItem(CALENDAR_SENT_KEY);
+  updateCalendar(year);
+}
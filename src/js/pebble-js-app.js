@@ -3,76 +3,539 @@ var xhrRequest = function (url, type, callback) {
   xhr.onload = function () {
     callback(this.responseText);
   };
+  xhr.onerror = xhr.ontimeout = function () {
+    callback(null);
+  };
   xhr.open(type, url);
   xhr.send();
 };
 
 var cityLocation = "";
 
-function locationSuccess(pos) {
-  // Construct URL
-  var url = "";
-  if(cityLocation === ""){
-	  url = "http://api.openweathermap.org/data/2.5/weather?lat=" +
-     	 pos.coords.latitude + "&lon=" + pos.coords.longitude + "&APPID=8c467bea8bafbdf81de33ba4aba6cabb";
-  }else{
-	  url =	"http://api.openweathermap.org/data/2.5/weather?q=" + cityLocation + "&APPID=8c467bea8bafbdf81de33ba4aba6cabb";
+// Weather service root, overridable in localStorage to point at a local server
+var WEATHER_BASE_URL_KEY = 'weatherBaseUrl';
+var DEFAULT_WEATHER_BASE_URL = 'http://api.openweathermap.org/data/2.5';
+var WEATHER_APP_ID = '8c467bea8bafbdf81de33ba4aba6cabb';
+
+// Last position, reused while younger than this
+var POSITION_KEY = 'position';
+var POSITION_TTL = 30 * 60 * 1000;
+
+// Last temperature pushed to the watch, unchanged ones aren't pushed again
+var WEATHER_SENT_KEY = 'weatherSent';
+
+// Last temperature and when it was fetched, shared with the watch's snapshot
+var WEATHER_SNAPSHOT_KEY = 'weatherSnapshot';
+var WEATHER_INTERVAL_KEY = 'weatherInterval';
+var DEFAULT_WEATHER_INTERVAL = 30;
+
+// Forecast block, see weather_forecast_received() on the watch
+var FORECAST_FORMAT_VERSION = 1;
+var FORECAST_SAMPLES = 8;
+
+// Binary birthday list, see birthdays_decode_chunk() on the watch
+var BIRTHDAY_FORMAT_VERSION = 1;
+var BIRTHDAY_CHUNK_FIRST = 0x01;
+var BIRTHDAY_CHUNK_LAST = 0x02;
+// The watch sizes its inbox for this, see BIRTHDAY_MESSAGE_MAX
+var BIRTHDAY_CHUNK_BYTES = 96;
+var BIRTHDAY_NAME_MAX = 20;
+var MAX_SEND_RETRIES = 3;
+
+// Settings synced to the watch as deltas, see KEY_CONFIG_VERSION on the watch:
+// what the config page asked for, what the watch confirmed, and what is on its way
+var CONFIG_KEY = 'config';
+var CONFIG_SENT_KEY = 'configSent';
+var CONFIG_PENDING_KEY = 'configPending';
+var CONFIG_FIELDS = ['twentyFourHourFormat', 'batteryDisplayOnOff', 'temperatureFormat',
+  'invertColor', 'weatherInterval', 'powerSaver', 'powerCritical'];
+// Birthday list the config page asked for, BIRTHDAY_LIST_KEY is the one the watch has
+var BIRTHDAY_WANTED_KEY = 'birthdayListWanted';
+
+// Set to ask a profiling build for its counters on every launch
+var PROFILE_KEY = 'profile';
+var PROFILE_COUNTERS = ['ticks', 'tickMs', 'tickMsMax', 'bitmapLoads', 'persistReads',
+  'persistWrites', 'persistAvoided', 'bytesIn', 'bytesOut', 'heapUsedMax', 'heapFreeMin'];
+var PROFILE_LAYERS = ['time', 'date', 'weather', 'battery', 'divider', 'panel'];
+
+// Latency breakdowns of the last traced weather requests, see profile_trace_report() on the watch
+var TRACES_KEY = 'traces';
+var TRACES_KEPT = 100;
+// Set to make traced requests skip the snapshot, so every trace covers the network
+var TRACE_FETCH_KEY = 'traceFetch';
+var TRACE_PHASES = ['outbox', 'queue', 'position', 'weather', 'forecast', 'reply', 'phone',
+  'transport', 'apply', 'total'];
+
+/** UTF-8 bytes of a name, cut at a character boundary **/
+function encodeName(name) {
+  var bytes = [];
+  for(var i = 0; i < name.length; i++){
+    var encoded = unescape(encodeURIComponent(name.charAt(i)));
+    if(bytes.length + encoded.length > BIRTHDAY_NAME_MAX)
+      break;
+    for(var j = 0; j < encoded.length; j++)
+      bytes.push(encoded.charCodeAt(j));
+  }
+  return bytes;
+}
+
+/** Turn "Name,MM/DD,Name,MM/DD" into chunks of [month][day][length][name] records **/
+function encodeBirthdays(list) {
+  var fields = list ? list.split(',') : [];
+  var chunks = [];
+  var chunk = null;
+
+  for(var i = 0; i + 1 < fields.length; i += 2){
+    var date = fields[i + 1].split('/');
+    var month = parseInt(date[0], 10);
+    var day = parseInt(date[1], 10);
+    if(!(month >= 1 && month <= 12 && day >= 1 && day <= 31))
+      continue;
+
+    var name = encodeName(fields[i].trim());
+    var record = [month, day, name.length].concat(name);
+    if(chunk === null || chunk.length + record.length > BIRTHDAY_CHUNK_BYTES){
+      chunk = [BIRTHDAY_FORMAT_VERSION, 0, 0];
+      chunks.push(chunk);
+    }
+    Array.prototype.push.apply(chunk, record);
+    chunk[2]++;
+  }
+
+  if(chunks.length === 0)
+    chunks.push([BIRTHDAY_FORMAT_VERSION, 0, 0]);
+  chunks[0][1] |= BIRTHDAY_CHUNK_FIRST;
+  chunks[chunks.length - 1][1] |= BIRTHDAY_CHUNK_LAST;
+  return chunks;
+}
+
+/** Send chunks under a key one at a time, each waiting for the watch's ack, then call done **/
+function sendChunks(key, chunks, done, index, retries) {
+  index = index || 0;
+  retries = retries || 0;
+  if(index >= chunks.length){
+    if(done)
+      done();
+    return;
+  }
+
+  var message = {};
+  message[key] = chunks[index];
+  Pebble.sendAppMessage(message,
+    function() {
+      sendChunks(key, chunks, done, index + 1, 0);
+    },
+    function() {
+      if(retries < MAX_SEND_RETRIES){
+        sendChunks(key, chunks, done, index, retries + 1);
+      } else {
+        console.log('Send ' + key + ' failed at chunk ' + index);
+      }
+    }
+  );
+}
+
+function weatherBaseUrl() {
+  return localStorage.getItem(WEATHER_BASE_URL_KEY) || DEFAULT_WEATHER_BASE_URL;
+}
+
+/** Query string for a position or, in city mode, the city name **/
+function weatherQuery(pos) {
+  var query = pos ? "lat=" + pos.latitude + "&lon=" + pos.longitude :
+    "q=" + encodeURIComponent(cityLocation);
+  return query + "&APPID=" + WEATHER_APP_ID;
+}
+
+// Weather request the watch is tracing, null when none is
+var weatherTrace = null;
+
+/** Start timing a watch request, hops are Date.now() times on the phone **/
+function startTrace(id) {
+  weatherTrace = { id: id, hops: { received: Date.now() } };
+}
+
+/** Note the first time the traced request reached a hop **/
+function traceHop(name) {
+  if(weatherTrace !== null && weatherTrace.hops[name] === undefined)
+    weatherTrace.hops[name] = Date.now();
+}
+
+/** Sorted values' percentile, nearest rank **/
+function percentile(sorted, p) {
+  return sorted[Math.max(0, Math.ceil(sorted.length * p / 100) - 1)];
+}
+
+/** Put the watch's report together with the phone's hops, log it and the percentiles so far **/
+function finishTrace(bytes) {
+  var read = function(index, size) {
+    var value = 0;
+    for(var i = size - 1; i >= 0; i--)
+      value = value * 256 + (bytes[index + i] || 0);
+    return value;
+  };
+  var id = read(0, 2);
+  if(weatherTrace === null || weatherTrace.id !== id){
+    console.log('Trace ' + id + ' unknown, dropped');
+    return;
   }
+  var hops = weatherTrace.hops;
+  weatherTrace = null;
 
-  
+  // Phone times are differences between hops that were reached, the watch's clock gives the rest
+  var since = function(from, to) {
+    return hops[from] !== undefined && hops[to] !== undefined ? hops[to] - hops[from] : 0;
+  };
+  var roundTrip = read(6, 4);
+  var phone = since('received', 'send');
+  var fetched = hops.forecast !== undefined ? 'forecast' : 'received';
+  var breakdown = {
+    id: id,
+    outbox: read(2, 2),
+    queue: hops.fetch !== undefined ? since('received', 'fetch') : 0,
+    position: since('fetch', 'position'),
+    weather: since(hops.position !== undefined ? 'position' : 'fetch', 'weather'),
+    forecast: since('weather', 'forecast'),
+    reply: since(fetched, 'send'),
+    phone: phone,
+    transport: Math.max(0, roundTrip - phone),
+    apply: read(4, 2),
+    total: roundTrip + read(4, 2)
+  };
+  console.log('Trace ' + JSON.stringify(breakdown));
+
+  var traces = readJson(TRACES_KEY, []);
+  traces.push(breakdown);
+  traces = traces.slice(-TRACES_KEPT);
+  localStorage.setItem(TRACES_KEY, JSON.stringify(traces));
+
+  var summary = TRACE_PHASES.map(function(phase) {
+    var sorted = traces.map(function(trace) { return trace[phase] || 0; })
+      .sort(function(a, b) { return a - b; });
+    return phase + ' ' + percentile(sorted, 50) + '/' + percentile(sorted, 90) + '/' + percentile(sorted, 99);
+  });
+  console.log('Trace p50/p90/p99 ms over ' + traces.length + ': ' + summary.join(', '));
+}
+
+/** Current conditions and forecast for a position, stored as the snapshot **/
+function fetchWeather(pos, callback) {
+  var query = weatherQuery(pos);
 
   // Send request to OpenWeatherMap
-  xhrRequest(url, 'GET', 
+  xhrRequest(weatherBaseUrl() + "/weather?" + query, 'GET', 
     function(responseText) {
-        
-        // responseText contains a JSON object with weather info
-        var json = JSON.parse(responseText);
-
-        // Temperature in Kelvin requires adjustment
-        var temperature = Math.round(json.main.temp * 9 / 5 - 459.67);
+        traceHop('weather');
+        var temperature;
+        try {
+          // Temperature in Kelvin requires adjustment
+          temperature = kelvinToFahrenheit(JSON.parse(responseText).main.temp);
+        } catch(e) {
+          console.log("Weather response unusable");
+          callback(null);
+          return;
+        }
         console.log("Temperature is " + temperature);
 
-        // Assemble dictionary using our keys
-        var dictionary = {
-            "KEY_TEMPERATURE": temperature
-        };
-
-        // Send to Pebble
-        Pebble.sendAppMessage(dictionary,
-            function(e) {
-                console.log("Weather info sent to Pebble successfully!");
-            },
-            function(e) {
-                console.log("Error sending weather info to Pebble!");
+        // The next hours go along so the watch can do without us for a while
+        xhrRequest(weatherBaseUrl() + "/forecast?" + query + "&cnt=" + FORECAST_SAMPLES, 'GET',
+          function(forecastText) {
+            traceHop('forecast');
+            var forecast = [];
+            try {
+              forecast = JSON.parse(forecastText).list.map(function(item) {
+                return { time: item.dt, temperature: kelvinToFahrenheit(item.main.temp) };
+              });
+            } catch(e) {
+              console.log("Forecast unavailable");
             }
+
+            var snapshot = { temperature: temperature, time: Date.now(), forecast: forecast };
+            localStorage.setItem(WEATHER_SNAPSHOT_KEY, JSON.stringify(snapshot));
+            callback(snapshot);
+          }
         );
     }      
   );
 }
 
-function locationError(err) {
-  console.log("Error requesting location!");
+function kelvinToFahrenheit(kelvin) {
+  return Math.round(kelvin * 9 / 5 - 459.67);
+}
+
+/** [version][count] then count x [uint32 time][int16 temperature], little endian **/
+function encodeForecast(samples) {
+  samples = (samples || []).slice(0, FORECAST_SAMPLES);
+  var bytes = [FORECAST_FORMAT_VERSION, samples.length];
+  samples.forEach(function(sample) {
+    for(var i = 0; i < 4; i++)
+      bytes.push((sample.time >>> (i * 8)) & 0xff);
+    bytes.push(sample.temperature & 0xff, (sample.temperature >> 8) & 0xff);
+  });
+  return bytes;
+}
+
+/** Freshness window in milliseconds, as configured for the watch **/
+function weatherFreshness() {
+  var minutes = parseInt(localStorage.getItem(WEATHER_INTERVAL_KEY), 10) || DEFAULT_WEATHER_INTERVAL;
+  return minutes * 60 * 1000;
+}
+
+function readSnapshot() {
+  try {
+    return JSON.parse(localStorage.getItem(WEATHER_SNAPSHOT_KEY));
+  } catch(e) {
+    return null;
+  }
+}
+
+function isFresh(snapshot) {
+  return snapshot !== null && typeof snapshot.temperature === 'number' &&
+    Date.now() - snapshot.time < weatherFreshness();
+}
+
+/** Send a temperature along with the time it was observed, unless the watch already shows it **/
+function sendTemperature(snapshot, requested) {
+  var key = snapshot.temperature + ':' + JSON.stringify(snapshot.forecast || []);
+  if(!requested && localStorage.getItem(WEATHER_SENT_KEY) === key){
+    console.log("Temperature unchanged, not sending");
+    return;
+  }
+
+  // Assemble dictionary using our keys
+  var dictionary = {
+    "KEY_TEMPERATURE": snapshot.temperature,
+    "weatherTime": Math.floor(snapshot.time / 1000)
+  };
+  if(snapshot.forecast && snapshot.forecast.length > 0)
+    dictionary.forecast = encodeForecast(snapshot.forecast);
+  // The watch matches the reply to its request by the trace id
+  if(weatherTrace !== null && requested){
+    dictionary.trace = weatherTrace.id;
+    traceHop('send');
+  }
+
+  // Send to Pebble
+  Pebble.sendAppMessage(dictionary,
+    function(e) {
+      traceHop('ack');
+      localStorage.setItem(WEATHER_SENT_KEY, key);
+      console.log("Weather info sent to Pebble successfully!");
+    },
+    function(e) {
+      console.log("Error sending weather info to Pebble!");
+    }
+  );
+}
+
+function readPosition() {
+  try {
+    var pos = JSON.parse(localStorage.getItem(POSITION_KEY));
+    return pos !== null && Date.now() - pos.time < POSITION_TTL ? pos : null;
+  } catch(e) {
+    return null;
+  }
+}
+
+/** Cached position, or a fresh fix when the cache has expired **/
+function getPosition(callback) {
+  var cached = readPosition();
+  if(cached !== null){
+    callback(cached);
+    return;
+  }
+
+  navigator.geolocation.getCurrentPosition(
+    function(pos) {
+      var position = { latitude: pos.coords.latitude, longitude: pos.coords.longitude, time: Date.now() };
+      localStorage.setItem(POSITION_KEY, JSON.stringify(position));
+      callback(position);
+    },
+    function(err) {
+      console.log("Error requesting location!");
+      callback(null);
+    },
+    {timeout: 15000, maximumAge: POSITION_TTL}
+  );
+}
+
+// Callers waiting on the fetch in flight, null when idle
+var weatherWaiters = null;
+
+/** Fetch the weather once for every caller that asks while a fetch is running **/
+function getWeather(callback) {
+  if(weatherWaiters !== null){
+    weatherWaiters.push(callback);
+    return;
+  }
+  weatherWaiters = [callback];
+  traceHop('fetch');
+
+  var finish = function(snapshot) {
+    var waiters = weatherWaiters;
+    weatherWaiters = null;
+    waiters.forEach(function(waiter) {
+      if(waiter)
+        waiter(snapshot);
+    });
+  };
+
+  if(cityLocation){
+    fetchWeather(null, finish);
+    return;
+  }
+  getPosition(function(pos) {
+    traceHop('position');
+    if(pos === null){
+      finish(null);
+    } else {
+      fetchWeather(pos, finish);
+    }
+  });
+}
+
+// Whether the watch asked for the weather while the fetch in flight runs
+var weatherReplyOwed = false;
+
+/** Serve the snapshot while fresh, otherwise fetch; a watch request always gets a reply **/
+function updateWeather(requested, force) {
+  var snapshot = readSnapshot();
+  if(!force && isFresh(snapshot)){
+    if(requested)
+      sendTemperature(snapshot, true);
+    return;
+  }
+
+  // Callers merged into one fetch share one reply
+  weatherReplyOwed = weatherReplyOwed || requested;
+  if(weatherWaiters !== null)
+    return;
+  getWeather(function(fetched) {
+    var owed = weatherReplyOwed;
+    weatherReplyOwed = false;
+    if(fetched !== null){
+      sendTemperature(fetched, owed);
+    } else if(owed && snapshot !== null){
+      sendTemperature(snapshot, true);
+    }
+  });
 }
 
-function getWeather() {
-  if(cityLocation === ""){
-	  navigator.geolocation.getCurrentPosition(
-		locationSuccess,
-		locationError,
-		{timeout: 15000, maximumAge: 60000}
-	  );
-  } else {
-  	  locationSuccess(cityLocation);
+function readJson(key, fallback) {
+  try {
+    return JSON.parse(localStorage.getItem(key)) || fallback;
+  } catch(e) {
+    return fallback;
   }
 }
 
+function toFlag(value) {
+  return value === true || value === 'true' || value === 1 ? 1 : 0;
+}
+
+/** Config page values as the watch reads them, fields the page left out are missing **/
+function normalizeConfig(data) {
+  var config = {};
+  if(data.twentyFourHourFormat !== undefined)
+    config.twentyFourHourFormat = toFlag(data.twentyFourHourFormat);
+  if(data.batteryDisplayOnOff !== undefined)
+    config.batteryDisplayOnOff = toFlag(data.batteryDisplayOnOff);
+  if(data.temperatureFormat)
+    config.temperatureFormat = String(data.temperatureFormat);
+  if(data.invertColor !== undefined)
+    config.invertColor = toFlag(data.invertColor);
+  if(data.weatherInterval)
+    config.weatherInterval = parseInt(data.weatherInterval, 10) || DEFAULT_WEATHER_INTERVAL;
+  // Battery percentages the watch's power tiers start at
+  if(data.powerSaver)
+    config.powerSaver = parseInt(data.powerSaver, 10);
+  if(data.powerCritical)
+    config.powerCritical = parseInt(data.powerCritical, 10);
+  return config;
+}
+
+/** Send the birthday list in acknowledged chunks, only when it differs from the watch's **/
+function syncBirthdays() {
+  var wanted = localStorage.getItem(BIRTHDAY_WANTED_KEY);
+  if(wanted === null || wanted === (localStorage.getItem(BIRTHDAY_LIST_KEY) || ''))
+    return;
+
+  sendChunks('birthdayData', encodeBirthdays(wanted), function() {
+    // Birthdays land in the index before the calendar points at them
+    localStorage.setItem(BIRTHDAY_LIST_KEY, wanted);
+    updateCalendar();
+  });
+}
+
+/** Send the settings that changed since the version the watch last confirmed **/
+function syncConfig() {
+  var wanted = readJson(CONFIG_KEY, {});
+  var sent = readJson(CONFIG_SENT_KEY, { version: 0, values: {} });
+
+  var message = {};
+  var changed = CONFIG_FIELDS.filter(function(field) {
+    return wanted[field] !== undefined && wanted[field] !== sent.values[field];
+  });
+  if(changed.length === 0){
+    syncBirthdays();
+    return;
+  }
+  changed.forEach(function(field) {
+    message[field] = wanted[field];
+  });
+
+  // The watch confirms the version once applied, until then the delta is resent.
+  // One still on its way is the newest, the next has to follow it or the watch's
+  // confirmation of the old one would stand for this one too
+  var pending = readJson(CONFIG_PENDING_KEY, null);
+  var last = pending !== null ? pending.version : sent.version;
+  message.configVersion = (last % 0xffff) + 1;
+  localStorage.setItem(CONFIG_PENDING_KEY, JSON.stringify({ version: message.configVersion, values: wanted }));
+  console.log('Sending config ' + message.configVersion + ': ' + changed.join(', '));
+  Pebble.sendAppMessage(message, syncBirthdays, function() {
+    console.log('Send config failed!');
+  });
+}
+
+/** The watch applied a config version **/
+function confirmConfig(version) {
+  var pending = readJson(CONFIG_PENDING_KEY, null);
+  if(pending === null || pending.version !== version)
+    return;
+  localStorage.setItem(CONFIG_SENT_KEY, JSON.stringify(pending));
+  localStorage.removeItem(CONFIG_PENDING_KEY);
+  console.log('Config ' + version + ' applied');
+}
+
+/** Log a counter snapshot, see profile_send() on the watch **/
+function logProfile(bytes) {
+  var read = function(index) {
+    var value = 0;
+    for(var i = 3; i >= 0; i--)
+      value = value * 256 + (bytes[index * 4 + i] || 0);
+    return value;
+  };
+  var counters = {};
+  PROFILE_COUNTERS.forEach(function(name, i) {
+    counters[name] = read(i);
+  });
+  var redraws = {};
+  PROFILE_LAYERS.forEach(function(name, i) {
+    redraws[name] = read(PROFILE_COUNTERS.length + i);
+  });
+  console.log('Profile: ' + JSON.stringify(counters) + ' redraws ' + JSON.stringify(redraws));
+}
+
 // Listen for when the watchface is opened
 Pebble.addEventListener('ready', 
   function(e) {
     console.log("PebbleKit JS ready!");
-	cityLocation = localStorage.getItem(100);
-    // Get the initial weather
-    getWeather();
+	cityLocation = localStorage.getItem(100) || "";
+    // The watch shows its own snapshot, only fetch when ours is old
+    updateWeather(false, false);
+    updateCalendar();
+    // Anything the watch didn't confirm last time goes again
+    syncConfig();
+    if(localStorage.getItem(PROFILE_KEY))
+      Pebble.sendAppMessage({ debug: 1 });
   }
 );
 
@@ -80,7 +543,26 @@ Pebble.addEventListener('ready',
 Pebble.addEventListener('appmessage',
   function(e) {
     console.log("AppMessage received!");
-    getWeather();
+    if(e.payload.debug !== undefined){
+      logProfile(e.payload.debug);
+      return;
+    }
+    if(e.payload.configVersion !== undefined){
+      confirmConfig(e.payload.configVersion);
+      return;
+    }
+    if(e.payload.calendarResync !== undefined){
+      resyncCalendar(e.payload.calendarResync);
+      return;
+    }
+    // A number tags a traced request, the bytes of a report come back on the same key
+    if(typeof e.payload.trace === 'object'){
+      finishTrace(e.payload.trace);
+      return;
+    }
+    if(typeof e.payload.trace === 'number')
+      startTrace(e.payload.trace);
+    updateWeather(true, typeof e.payload.trace === 'number' && !!localStorage.getItem(TRACE_FETCH_KEY));
   }                     
 );
 
@@ -97,21 +579,21 @@ Pebble.addEventListener('webviewclosed', function(e) {
 	localStorage.setItem(100, configData.location);
 	if(configData.useLocation)
 		localStorage.setItem(100, "");
-	cityLocation = localStorage.getItem(100);
-	getWeather();
-
-	if(configData.temperatureFormat){
-		Pebble.sendAppMessage({
-			twentyFourHourFormat: configData.twentyFourHourFormat,
-			batteryDisplayOnOff: configData.batteryDisplayOnOff,
-			temperatureFormat: configData.temperatureFormat,
-			birthdayList: configData.birthdayList,
-			invertColor: configData.invertColor
-		}, function(){
-			console.log('Send config successful!');
-		}, function(){
-			console.log('Send config failed!');
-		});		
-	}
+	cityLocation = localStorage.getItem(100) || "";
+	if(configData.weatherInterval)
+		localStorage.setItem(WEATHER_INTERVAL_KEY, configData.weatherInterval);
+	// The location may have changed, so the cached weather can't be trusted
+	localStorage.removeItem(POSITION_KEY);
+	updateWeather(false, true);
+
+	// Fields the page sent replace what was asked for before, the rest stay
+	var wanted = readJson(CONFIG_KEY, {});
+	var config = normalizeConfig(configData);
+	for(var field in config)
+		wanted[field] = config[field];
+	localStorage.setItem(CONFIG_KEY, JSON.stringify(wanted));
+	if(configData.birthdayList !== undefined)
+		localStorage.setItem(BIRTHDAY_WANTED_KEY, configData.birthdayList || '');
+	syncConfig();
 });
 
@@ -0,0 +1,94 @@
+#include <pebble.h>
+#include "messages.h"
+#include "weather.h"
+#include "birthdays.h"
+#include "calendar.h"
+#include "profile.h"
+
+// Every tuple carries a 4 byte key, a type byte and a 2 byte length
+#define TUPLE_HEADER 7
+// Count byte in front of the tuples
+#define DICT_HEADER 1
+
+// Ints from PebbleKit JS arrive as int32
+#define INT_SIZE sizeof(int32_t)
+
+/** Messages that travel together, each is sized on its own **/
+typedef enum {
+    MESSAGE_WEATHER,
+    MESSAGE_CONFIG,
+    MESSAGE_BIRTHDAYS,
+    MESSAGE_CALENDAR,
+    MESSAGE_DEBUG,
+    MESSAGE_WEATHER_REQUEST,
+    MESSAGE_CONFIG_CONFIRM,
+    MESSAGE_DEBUG_REPLY,
+    MESSAGE_TRACE_REPORT,
+    MESSAGE_CALENDAR_RESYNC,
+    MESSAGE_COUNT
+} MessageGroup;
+
+/** One appKey of a message and the most it may carry **/
+typedef struct {
+    uint32_t key;
+    MessageGroup group;
+    bool outbound;
+    uint16_t size;
+} MessageField;
+
+static const MessageField s_schema[] = {
+    // Phone to watch
+    { KEY_TEMPERATURE, MESSAGE_WEATHER, false, INT_SIZE },
+    { KEY_WEATHER_TIME, MESSAGE_WEATHER, false, INT_SIZE },
+    { KEY_WEATHER_FORECAST, MESSAGE_WEATHER, false, WEATHER_FORECAST_MESSAGE_MAX },
+    { KEY_TWENTY_FOUR_HOUR_FORMAT, MESSAGE_CONFIG, false, INT_SIZE },
+    { KEY_BATTERY_ON_OFF, MESSAGE_CONFIG, false, INT_SIZE },
+    { KEY_TEMP_TYPE, MESSAGE_CONFIG, false, sizeof("Fahrenheit") },
+    { KEY_INVERT_COLOR, MESSAGE_CONFIG, false, INT_SIZE },
+    { KEY_WEATHER_INTERVAL, MESSAGE_CONFIG, false, INT_SIZE },
+    { KEY_POWER_SAVER, MESSAGE_CONFIG, false, INT_SIZE },
+    { KEY_POWER_CRITICAL, MESSAGE_CONFIG, false, INT_SIZE },
+    { KEY_CONFIG_VERSION, MESSAGE_CONFIG, false, INT_SIZE },
+    { KEY_BIRTHDAY_DATA, MESSAGE_BIRTHDAYS, false, BIRTHDAY_MESSAGE_MAX },
+    { KEY_CALENDAR, MESSAGE_CALENDAR, false, CALENDAR_MESSAGE_MAX },
+    { KEY_DEBUG, MESSAGE_DEBUG, false, INT_SIZE },
+#ifdef FESTIVE_PROFILE
+    { KEY_TRACE, MESSAGE_WEATHER, false, INT_SIZE },
+#endif
+
+    // Watch to phone
+    { KEY_TEMPERATURE, MESSAGE_WEATHER_REQUEST, true, sizeof(uint8_t) },
+    { KEY_CONFIG_VERSION, MESSAGE_CONFIG_CONFIRM, true, INT_SIZE },
+    { KEY_CALENDAR_RESYNC, MESSAGE_CALENDAR_RESYNC, true, sizeof(uint16_t) },
+#ifdef FESTIVE_PROFILE
+    { KEY_DEBUG, MESSAGE_DEBUG_REPLY, true, PROFILE_SNAPSHOT_SIZE },
+    { KEY_TRACE, MESSAGE_WEATHER_REQUEST, true, sizeof(uint16_t) },
+    { KEY_TRACE, MESSAGE_TRACE_REPORT, true, PROFILE_TRACE_REPORT_SIZE },
+#endif
+};
+
+/** Dictionary size of the largest message going one way **/
+static uint32_t largest_message(bool outbound){
+    uint32_t sizes[MESSAGE_COUNT] = { 0 };
+    uint32_t largest = 0;
+
+    for(size_t i = 0; i < ARRAY_LENGTH(s_schema); i++){
+        const MessageField *field = &s_schema[i];
+        if(field->outbound != outbound)
+            continue;
+        if(sizes[field->group] == 0)
+            sizes[field->group] = DICT_HEADER;
+        sizes[field->group] += TUPLE_HEADER + field->size;
+        if(sizes[field->group] > largest)
+            largest = sizes[field->group];
+    }
+    return largest;
+}
+
+uint32_t messages_inbox_size(void){
+    return largest_message(false);
+}
+
+uint32_t messages_outbox_size(void){
+    return largest_message(true);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <pebble.h>
+
+// AppMessage keys of the settings, persisted together by settings.c
+#define KEY_TWENTY_FOUR_HOUR_FORMAT 1
+#define KEY_BATTERY_ON_OFF 2
+#define KEY_TEMP_TYPE 3
+#define KEY_BIRTHDAY_LIST 4
+#define KEY_INVERT_COLOR 5
+#define KEY_BIRTHDAY_DATA 6
+#define KEY_WEATHER_INTERVAL 7
+#define KEY_POWER_SAVER 15
+#define KEY_POWER_CRITICAL 16
+// Version of a config sync from the phone, sent back once it is applied
+#define KEY_CONFIG_VERSION 12
+
+/** Inbox size that fits the largest message the phone sends **/
+uint32_t messages_inbox_size(void);
+
+/** Outbox size that fits the largest message the watch sends **/
+uint32_t messages_outbox_size(void);
@@ -0,0 +1,161 @@
+#include <pebble.h>
+#include "panel.h"
+#include "render.h"
+#include "text.h"
+
+// Where the parts sit inside the panel
+#define PANEL_BANNER_FRAME GRect(2, 52, 140, 20)
+#define PANEL_BT_ICON_FRAME GRect(59, 12, 30, 30)
+
+static Layer *s_layer;
+static GBitmap *s_background;
+static GBitmap *s_bt_icon;
+static bool s_bt_visible;
+static bool s_inverted;
+static bool s_has_banner;
+// Countdowns are the longest banners, longer than a birthday greeting
+static char s_banner[TEXT_COUNTDOWN_SIZE];
+
+// Copy of what the panel last drew, NULL until composited or when it didn't fit
+static GBitmap *s_cache;
+static bool s_cache_valid;
+
+/** Something in the panel changed, it is composited again on the next frame **/
+static void invalidate(void){
+    s_cache_valid = false;
+    render_invalidate(RENDER_PANEL);
+}
+
+static void compose(Layer *layer, GContext *ctx){
+    GRect bounds = layer_get_bounds(layer);
+    GColor background = s_inverted ? GColorWhite : GColorBlack;
+    GColor foreground = s_inverted ? GColorBlack : GColorWhite;
+    GCompOp bitmap_mode = s_inverted ? GCompOpAssignInverted : GCompOpAssign;
+
+    graphics_context_set_fill_color(ctx, background);
+    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+
+    graphics_context_set_compositing_mode(ctx, bitmap_mode);
+    if(s_background != NULL){
+        // Centered like the BitmapLayer it replaces
+        GRect image = gbitmap_get_bounds(s_background);
+        image.origin = GPoint((bounds.size.w - image.size.w) / 2, (bounds.size.h - image.size.h) / 2);
+        graphics_draw_bitmap_in_rect(ctx, s_background, image);
+    }
+
+    if(s_has_banner){
+        graphics_context_set_fill_color(ctx, background);
+        graphics_fill_rect(ctx, PANEL_BANNER_FRAME, 0, GCornerNone);
+        graphics_context_set_text_color(ctx, foreground);
+        graphics_draw_text(ctx, s_banner, fonts_get_system_font(FONT_KEY_GOTHIC_14), PANEL_BANNER_FRAME,
+                           GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
+    }
+
+    if(s_bt_visible && s_bt_icon != NULL){
+        graphics_context_set_compositing_mode(ctx, bitmap_mode);
+        graphics_draw_bitmap_in_rect(ctx, s_bt_icon, PANEL_BT_ICON_FRAME);
+    }
+}
+
+/** Copy the panel's rows out of the framebuffer, false if that isn't possible **/
+static bool capture(Layer *layer, GContext *ctx){
+    GRect frame = layer_get_frame(layer);
+    GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+    if(frame_buffer == NULL)
+        return false;
+
+    GBitmapFormat format = gbitmap_get_format(frame_buffer);
+    int bits = format == GBitmapFormat1Bit ? 1 : 8;
+    bool captured = false;
+
+    // Rows are copied whole bytes at a time, the panel has to start on a byte
+    if((frame.origin.x * bits) % 8 == 0){
+        if(s_cache == NULL)
+            s_cache = gbitmap_create_blank(frame.size, format);
+        if(s_cache != NULL){
+            const uint8_t *source = gbitmap_get_data(frame_buffer);
+            uint16_t source_stride = gbitmap_get_bytes_per_row(frame_buffer);
+            uint8_t *target = gbitmap_get_data(s_cache);
+            uint16_t target_stride = gbitmap_get_bytes_per_row(s_cache);
+            size_t row_bytes = (frame.size.w * bits + 7) / 8;
+
+            for(int y = 0; y < frame.size.h; y++)
+                memcpy(target + y * target_stride,
+                       source + (frame.origin.y + y) * source_stride + frame.origin.x * bits / 8, row_bytes);
+            captured = true;
+        }
+    }
+
+    graphics_release_frame_buffer(ctx, frame_buffer);
+    return captured;
+}
+
+static void panel_update_proc(Layer *layer, GContext *ctx){
+    if(s_cache_valid){
+        graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+        graphics_draw_bitmap_in_rect(ctx, s_cache, layer_get_bounds(layer));
+        return;
+    }
+
+    compose(layer, ctx);
+    s_cache_valid = capture(layer, ctx);
+}
+
+Layer *panel_create(GRect frame){
+    s_layer = layer_create(frame);
+    layer_set_update_proc(s_layer, panel_update_proc);
+    s_bt_icon = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BT_ICON);
+    s_cache_valid = false;
+    return s_layer;
+}
+
+void panel_destroy(void){
+    if(s_cache != NULL){
+        gbitmap_destroy(s_cache);
+        s_cache = NULL;
+    }
+    s_cache_valid = false;
+    gbitmap_destroy(s_bt_icon);
+    s_bt_icon = NULL;
+    layer_destroy(s_layer);
+    s_layer = NULL;
+    s_background = NULL;
+    s_has_banner = false;
+}
+
+void panel_set_background(GBitmap *bitmap){
+    if(bitmap == s_background)
+        return;
+    s_background = bitmap;
+    invalidate();
+}
+
+void panel_set_banner(const char *text){
+    if(text == NULL){
+        if(s_has_banner){
+            s_has_banner = false;
+            invalidate();
+        }
+        return;
+    }
+    if(s_has_banner && strncmp(text, s_banner, sizeof(s_banner)) == 0)
+        return;
+    s_has_banner = true;
+    strncpy(s_banner, text, sizeof(s_banner) - 1);
+    s_banner[sizeof(s_banner) - 1] = '\0';
+    invalidate();
+}
+
+void panel_set_bt_visible(bool visible){
+    if(visible == s_bt_visible)
+        return;
+    s_bt_visible = visible;
+    invalidate();
+}
+
+void panel_set_inverted(bool inverted){
+    if(inverted == s_inverted)
+        return;
+    s_inverted = inverted;
+    invalidate();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <pebble.h>
+
+/*
+ * The upper half of the face: the day's background, its banner and the
+ * Bluetooth icon. They change a few times a day at most, so they are
+ * composited once, kept as a copy of the framebuffer and blitted back
+ * on every other frame.
+ */
+
+/** Create the panel layer, to be added to the window **/
+Layer *panel_create(GRect frame);
+
+/** Destroy the layer and the cached copy **/
+void panel_destroy(void);
+
+/** Background bitmap, not owned by the panel **/
+void panel_set_background(GBitmap *bitmap);
+
+/** Banner text over the background, NULL for none **/
+void panel_set_banner(const char *text);
+
+/** Show the Bluetooth icon **/
+void panel_set_bt_visible(bool visible);
+
+/** Light on dark or inverted **/
+void panel_set_inverted(bool inverted);
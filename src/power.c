@@ -0,0 +1,88 @@
+#include <pebble.h>
+#include "power.h"
+
+// Charge has to climb this far past a tier's threshold before it is left
+#define POWER_HYSTERESIS 10
+
+static const PowerPolicy s_policies[POWER_TIER_COUNT] = {
+    [POWER_NORMAL] = {
+        .weather_stretch = 1,
+        .vibrate = true,
+        .swap_background = true,
+        .minute_only = false,
+    },
+    [POWER_SAVER] = {
+        .weather_stretch = 2,
+        .vibrate = false,
+        .swap_background = true,
+        .minute_only = false,
+    },
+    [POWER_CRITICAL] = {
+        .weather_stretch = 4,
+        .vibrate = false,
+        .swap_background = false,
+        .minute_only = true,
+    },
+};
+
+// Charge at or below which each tier starts, saver and critical come from the settings
+static uint8_t s_thresholds[POWER_TIER_COUNT] = {
+    [POWER_NORMAL] = 100,
+    [POWER_SAVER] = POWER_SAVER_DEFAULT,
+    [POWER_CRITICAL] = POWER_CRITICAL_DEFAULT,
+};
+static PowerTier s_tier = POWER_NORMAL;
+
+/** Deepest tier whose threshold the charge is at or below **/
+static PowerTier tier_for(uint8_t charge){
+    PowerTier tier = POWER_NORMAL;
+    for(int i = POWER_NORMAL + 1; i < POWER_TIER_COUNT; i++){
+        if(charge <= s_thresholds[i])
+            tier = i;
+    }
+    return tier;
+}
+
+/** Enter a tier, true if it is another one **/
+static bool move_to(PowerTier tier, uint8_t charge){
+    if(tier == s_tier)
+        return false;
+    APP_LOG(APP_LOG_LEVEL_INFO, "Power tier %d -> %d at %d%%", s_tier, tier, charge);
+    s_tier = tier;
+    return true;
+}
+
+bool power_set_thresholds(uint8_t saver, uint8_t critical, BatteryChargeState state){
+    if(critical < saver && saver < 100){
+        s_thresholds[POWER_SAVER] = saver;
+        s_thresholds[POWER_CRITICAL] = critical;
+    }else{
+        APP_LOG(APP_LOG_LEVEL_WARNING, "Power thresholds %d/%d ignored", saver, critical);
+        s_thresholds[POWER_SAVER] = POWER_SAVER_DEFAULT;
+        s_thresholds[POWER_CRITICAL] = POWER_CRITICAL_DEFAULT;
+    }
+    // Asked for by the user, so no hysteresis either way
+    return move_to(tier_for(state.charge_percent), state.charge_percent);
+}
+
+bool power_update(BatteryChargeState state){
+    PowerTier tier = tier_for(state.charge_percent);
+
+    // Dropping is immediate, climbing back needs the charger and headroom past each threshold
+    if(tier < s_tier){
+        bool charging = state.is_charging || state.is_plugged;
+        tier = s_tier;
+        while(tier > POWER_NORMAL && charging &&
+              state.charge_percent >= s_thresholds[tier] + POWER_HYSTERESIS)
+            tier--;
+    }
+    return move_to(tier, state.charge_percent);
+}
+
+PowerTier power_tier(void){
+    return s_tier;
+}
+
+const PowerPolicy *power_policy(void){
+    return &s_policies[s_tier];
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <pebble.h>
+
+/** Power tiers, each one saving more than the last **/
+typedef enum {
+    POWER_NORMAL,
+    POWER_SAVER,
+    POWER_CRITICAL,
+    POWER_TIER_COUNT
+} PowerTier;
+
+// Battery percentages at or below which the tiers start, until the settings say otherwise
+#define POWER_SAVER_DEFAULT 30
+#define POWER_CRITICAL_DEFAULT 10
+
+/** What the face may do in a tier **/
+typedef struct {
+    // The weather interval is multiplied by this
+    uint8_t weather_stretch;
+    // Vibrate when the phone disconnects
+    bool vibrate;
+    // Swap the background image at midnight
+    bool swap_background;
+    // Redraw only the time every minute, the weather waits for the hour
+    bool minute_only;
+} PowerPolicy;
+
+/**
+ * Charge at which saver and critical start, from the settings. Critical has to
+ * start below saver, otherwise the defaults stay. The tier is picked afresh for
+ * the battery state; returns true when that moved the face to another tier.
+ **/
+bool power_set_thresholds(uint8_t saver, uint8_t critical, BatteryChargeState state);
+
+/** A new battery state, returns true when it moved the face to another tier **/
+bool power_update(BatteryChargeState state);
+
+/** Tier the face is in **/
+PowerTier power_tier(void);
+
+/** Rules of the current tier **/
+const PowerPolicy *power_policy(void);
@@ -0,0 +1,151 @@
+#include <pebble.h>
+#include "profile.h"
+
+#ifdef FESTIVE_PROFILE
+
+/** What the phone gets back, little endian like everything on the watch **/
+typedef struct {
+    uint32_t counters[PROFILE_COUNTER_COUNT];
+    uint32_t redraws[RENDER_SLOT_COUNT];
+} ProfileSnapshot;
+
+static uint32_t s_counters[PROFILE_COUNTER_COUNT] = {
+    [PROFILE_HEAP_FREE_MIN] = UINT32_MAX,
+};
+static size_t s_heap_parts[PROFILE_HEAP_PART_COUNT];
+
+/** The weather request being traced, times on the profile_now() clock **/
+static struct {
+    uint16_t next;
+    uint16_t id;
+    uint32_t sent;
+    uint32_t acked;
+    uint32_t arrived;
+    uint32_t applied;
+    bool answered;
+    bool owed;
+} s_trace;
+
+void profile_count(ProfileCounter counter, uint32_t amount){
+    s_counters[counter] += amount;
+}
+
+uint32_t profile_now(void){
+    time_t seconds;
+    uint16_t ms = time_ms(&seconds, NULL);
+    return (uint32_t)seconds * 1000 + ms;
+}
+
+void profile_tick_done(uint32_t start){
+    uint32_t elapsed = profile_now() - start;
+    s_counters[PROFILE_TICKS]++;
+    s_counters[PROFILE_TICK_MS] += elapsed;
+    if(elapsed > s_counters[PROFILE_TICK_MS_MAX])
+        s_counters[PROFILE_TICK_MS_MAX] = elapsed;
+    profile_sample_heap();
+}
+
+void profile_sample_heap(void){
+    uint32_t used = heap_bytes_used();
+    uint32_t free = heap_bytes_free();
+    if(used > s_counters[PROFILE_HEAP_USED_MAX])
+        s_counters[PROFILE_HEAP_USED_MAX] = used;
+    if(free < s_counters[PROFILE_HEAP_FREE_MIN])
+        s_counters[PROFILE_HEAP_FREE_MIN] = free;
+}
+
+void profile_message(ProfileCounter counter, DictionaryIterator *iterator){
+    s_counters[counter] += (const uint8_t *)iterator->end - (const uint8_t *)iterator->dictionary;
+}
+
+void profile_send(void){
+    ProfileSnapshot snapshot;
+    memcpy(snapshot.counters, s_counters, sizeof(snapshot.counters));
+    for(int i = 0; i < RENDER_SLOT_COUNT; i++)
+        snapshot.redraws[i] = render_get_redraws(i);
+
+    DictionaryIterator *iter;
+    if(app_message_outbox_begin(&iter) != APP_MSG_OK)
+        return;
+    dict_write_data(iter, KEY_DEBUG, (const uint8_t *)&snapshot, sizeof(snapshot));
+    app_message_outbox_send();
+}
+
+void profile_heap_claimed(ProfileHeapPart part, size_t bytes){
+    s_heap_parts[part] += bytes;
+}
+
+void profile_heap_report(void){
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Heap: app message %d, layers %d, fonts %d, bitmaps %d, used %d, free %d",
+        (int)s_heap_parts[PROFILE_HEAP_APP_MESSAGE], (int)s_heap_parts[PROFILE_HEAP_LAYERS],
+        (int)s_heap_parts[PROFILE_HEAP_FONTS], (int)s_heap_parts[PROFILE_HEAP_BITMAPS],
+        (int)heap_bytes_used(), (int)heap_bytes_free());
+}
+
+static uint16_t clamp_ms(uint32_t ms){
+    return ms > UINT16_MAX ? UINT16_MAX : (uint16_t)ms;
+}
+
+static void write_le(uint8_t *bytes, uint32_t value, int size){
+    for(int i = 0; i < size; i++)
+        bytes[i] = (value >> (i * 8)) & 0xff;
+}
+
+void profile_trace_request(DictionaryIterator *iter){
+    // 0 means untraced on the phone
+    if(++s_trace.next == 0)
+        s_trace.next = 1;
+    s_trace.id = s_trace.next;
+    s_trace.sent = s_trace.acked = profile_now();
+    s_trace.answered = false;
+    dict_write_uint16(iter, KEY_TRACE, s_trace.id);
+}
+
+void profile_trace_sent(DictionaryIterator *iterator){
+    // The report travels on the same key as a byte array
+    Tuple *trace = dict_find(iterator, KEY_TRACE);
+    if(trace != NULL && trace->type == TUPLE_UINT && trace->value->uint16 == s_trace.id)
+        s_trace.acked = profile_now();
+}
+
+void profile_trace_reply(DictionaryIterator *iterator){
+    Tuple *trace = dict_find(iterator, KEY_TRACE);
+    if(trace == NULL || s_trace.id == 0 || (uint16_t)trace->value->int32 != s_trace.id || s_trace.answered)
+        return;
+    s_trace.arrived = profile_now();
+    s_trace.answered = true;
+}
+
+void profile_trace_applied(void){
+    if(s_trace.answered && !s_trace.owed && s_trace.id != 0){
+        s_trace.applied = profile_now();
+        s_trace.owed = true;
+    }
+    profile_trace_report();
+}
+
+void profile_trace_report(void){
+    if(!s_trace.owed)
+        return;
+
+    uint8_t report[PROFILE_TRACE_REPORT_SIZE];
+    write_le(report, s_trace.id, 2);
+    write_le(report + 2, clamp_ms(s_trace.acked - s_trace.sent), 2);
+    write_le(report + 4, clamp_ms(s_trace.applied - s_trace.arrived), 2);
+    write_le(report + 6, s_trace.arrived - s_trace.sent, 4);
+
+    DictionaryIterator *iter;
+    if(app_message_outbox_begin(&iter) != APP_MSG_OK)
+        return;
+    dict_write_data(iter, KEY_TRACE, report, sizeof(report));
+    if(app_message_outbox_send() != APP_MSG_OK)
+        return;
+
+    PROFILE_LOG("Trace %d: outbox %d ms, round trip %d ms, apply %d ms", s_trace.id,
+        (int)(s_trace.acked - s_trace.sent), (int)(s_trace.arrived - s_trace.sent),
+        (int)(s_trace.applied - s_trace.arrived));
+    s_trace.owed = false;
+    s_trace.id = 0;
+}
+
+#endif
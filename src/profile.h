@@ -0,0 +1,124 @@
+#pragma once
+
+#include <pebble.h>
+#include "render.h"
+
+// AppMessage key the phone asks for a counter snapshot with, the reply comes back on it
+#define KEY_DEBUG 10
+// AppMessage key a weather request's trace id travels on, the trace report comes back on it
+#define KEY_TRACE 13
+
+/** Counters kept in profiling builds **/
+typedef enum {
+    PROFILE_TICKS,
+    PROFILE_TICK_MS,
+    PROFILE_TICK_MS_MAX,
+    PROFILE_BITMAP_LOADS,
+    PROFILE_PERSIST_READS,
+    PROFILE_PERSIST_WRITES,
+    PROFILE_PERSIST_AVOIDED,
+    PROFILE_BYTES_IN,
+    PROFILE_BYTES_OUT,
+    PROFILE_HEAP_USED_MAX,
+    PROFILE_HEAP_FREE_MIN,
+    PROFILE_COUNTER_COUNT
+} ProfileCounter;
+
+// Every counter then the redraws per layer, as uint32
+#define PROFILE_SNAPSHOT_SIZE ((PROFILE_COUNTER_COUNT + RENDER_SLOT_COUNT) * sizeof(uint32_t))
+
+// Trace report: [id uint16][outbox ms uint16][apply ms uint16][round trip ms uint32]
+#define PROFILE_TRACE_REPORT_SIZE 10
+
+/** Parts of the heap the startup report breaks out **/
+typedef enum {
+    PROFILE_HEAP_APP_MESSAGE,
+    PROFILE_HEAP_LAYERS,
+    PROFILE_HEAP_FONTS,
+    PROFILE_HEAP_BITMAPS,
+    PROFILE_HEAP_PART_COUNT
+} ProfileHeapPart;
+
+/*
+ * Build with FESTIVE_PROFILE defined (FESTIVE_PROFILE=1 in the environment
+ * when running the build) to turn the counters and debug logging on. In
+ * release builds every macro below expands to nothing, arguments included.
+ */
+#ifdef FESTIVE_PROFILE
+
+/** Add to a counter **/
+void profile_count(ProfileCounter counter, uint32_t amount);
+
+/** Milliseconds on a wrapping clock, only differences mean anything **/
+uint32_t profile_now(void);
+
+/** A tick handler that started at profile_now() time is done **/
+void profile_tick_done(uint32_t start);
+
+/** Record the heap high-water marks **/
+void profile_sample_heap(void);
+
+/** Count the bytes of an incoming or outgoing message **/
+void profile_message(ProfileCounter counter, DictionaryIterator *iterator);
+
+/** Reply to the phone with every counter and the redraws per layer **/
+void profile_send(void);
+
+/** Heap a part of the face claimed **/
+void profile_heap_claimed(ProfileHeapPart part, size_t bytes);
+
+/** Log what each part claimed and what is left **/
+void profile_heap_report(void);
+
+/** Tag a weather request with a new trace id **/
+void profile_trace_request(DictionaryIterator *iter);
+
+/** The phone acknowledged an outgoing message, note it if it was the traced request **/
+void profile_trace_sent(DictionaryIterator *iterator);
+
+/** A message came in, note its arrival if it answers the traced request **/
+void profile_trace_reply(DictionaryIterator *iterator);
+
+/** The message that answered the traced request is applied **/
+void profile_trace_applied(void);
+
+/** Send the trace report if one is owed and the outbox is free **/
+void profile_trace_report(void);
+
+#define PROFILE_COUNT(counter, amount) profile_count((counter), (amount))
+#define PROFILE_TIMER_START(name) uint32_t name = profile_now()
+#define PROFILE_ELAPSED(name) (profile_now() - (name))
+#define PROFILE_TICK_DONE(name) profile_tick_done(name)
+#define PROFILE_SAMPLE_HEAP() profile_sample_heap()
+#define PROFILE_MESSAGE(counter, iterator) profile_message((counter), (iterator))
+#define PROFILE_SEND() profile_send()
+#define PROFILE_HEAP_START(name) size_t name = heap_bytes_used()
+#define PROFILE_HEAP_CLAIMED(part, name) profile_heap_claimed((part), heap_bytes_used() - (name))
+#define PROFILE_HEAP_REPORT() profile_heap_report()
+#define PROFILE_TRACE_REQUEST(iter) profile_trace_request(iter)
+#define PROFILE_TRACE_SENT(iterator) profile_trace_sent(iterator)
+#define PROFILE_TRACE_REPLY(iterator) profile_trace_reply(iterator)
+#define PROFILE_TRACE_APPLIED() profile_trace_applied()
+#define PROFILE_TRACE_REPORT() profile_trace_report()
+#define PROFILE_LOG(...) APP_LOG(APP_LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#else
+
+#define PROFILE_COUNT(counter, amount)
+#define PROFILE_TIMER_START(name)
+#define PROFILE_ELAPSED(name)
+#define PROFILE_TICK_DONE(name)
+#define PROFILE_SAMPLE_HEAP()
+#define PROFILE_MESSAGE(counter, iterator)
+#define PROFILE_SEND()
+#define PROFILE_HEAP_START(name)
+#define PROFILE_HEAP_CLAIMED(part, name)
+#define PROFILE_HEAP_REPORT()
+#define PROFILE_TRACE_REQUEST(iter)
+#define PROFILE_TRACE_SENT(iterator)
+#define PROFILE_TRACE_REPLY(iterator)
+#define PROFILE_TRACE_APPLIED()
+#define PROFILE_TRACE_REPORT()
+#define PROFILE_LOG(...)
+
+#endif
@@ -0,0 +1,110 @@
+#include <pebble.h>
+#include "render.h"
+
+// Longest text compared by content, longer text is always redrawn
+#define RENDER_TEXT_MAX 32
+
+typedef struct {
+    Layer *layer;
+    TextLayer *text_layer;
+    const char *shown_text;
+    const char *pending_text;
+    char shown_copy[RENDER_TEXT_MAX];
+    bool has_pending_text;
+    bool dirty;
+    uint32_t redraws;
+} RenderTarget;
+
+static RenderTarget s_targets[RENDER_SLOT_COUNT];
+static AppTimer *s_flush_timer;
+
+static void flush_callback(void *context){
+    s_flush_timer = NULL;
+    render_flush();
+}
+
+/** Invalidations in one event loop turn are merged into one flush **/
+static void schedule_flush(void){
+    if(s_flush_timer == NULL)
+        s_flush_timer = app_timer_register(0, flush_callback, NULL);
+}
+
+/** Whether the queued text would change what the layer shows **/
+static bool text_changed(RenderTarget *target){
+    const char *text = target->pending_text;
+    if(text == NULL || target->shown_text == NULL)
+        return text != target->shown_text;
+    if(text != target->shown_text)
+        return true;
+    return strlen(text) >= RENDER_TEXT_MAX || strcmp(text, target->shown_copy) != 0;
+}
+
+void render_add_text_layer(RenderSlot slot, TextLayer *layer){
+    s_targets[slot] = (RenderTarget){
+        .layer = text_layer_get_layer(layer),
+        .text_layer = layer,
+    };
+}
+
+void render_add_layer(RenderSlot slot, Layer *layer){
+    s_targets[slot] = (RenderTarget){
+        .layer = layer,
+    };
+}
+
+void render_remove_all(void){
+    if(s_flush_timer != NULL){
+        app_timer_cancel(s_flush_timer);
+        s_flush_timer = NULL;
+    }
+    for(int i = 0; i < RENDER_SLOT_COUNT; i++){
+        uint32_t redraws = s_targets[i].redraws;
+        s_targets[i] = (RenderTarget){ .redraws = redraws };
+    }
+}
+
+void render_set_text(RenderSlot slot, const char *text){
+    RenderTarget *target = &s_targets[slot];
+    if(target->text_layer == NULL)
+        return;
+    target->pending_text = text;
+    target->has_pending_text = true;
+    schedule_flush();
+}
+
+void render_invalidate(RenderSlot slot){
+    RenderTarget *target = &s_targets[slot];
+    if(target->layer == NULL)
+        return;
+    target->dirty = true;
+    schedule_flush();
+}
+
+void render_flush(void){
+    for(int i = 0; i < RENDER_SLOT_COUNT; i++){
+        RenderTarget *target = &s_targets[i];
+
+        if(target->has_pending_text){
+            target->has_pending_text = false;
+            if(text_changed(target)){
+                // Setting the text marks the layer dirty by itself
+                text_layer_set_text(target->text_layer, target->pending_text);
+                target->shown_text = target->pending_text;
+                if(target->shown_text != NULL)
+                    strncpy(target->shown_copy, target->shown_text, sizeof(target->shown_copy));
+                target->redraws++;
+                target->dirty = false;
+            }
+        }
+
+        if(target->dirty){
+            target->dirty = false;
+            layer_mark_dirty(target->layer);
+            target->redraws++;
+        }
+    }
+}
+
+uint32_t render_get_redraws(RenderSlot slot){
+    return s_targets[slot].redraws;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <pebble.h>
+
+/** Layers the render scheduler knows about **/
+typedef enum {
+    RENDER_TIME,
+    RENDER_DATE,
+    RENDER_WEATHER,
+    RENDER_BATTERY,
+    RENDER_DIVIDER,
+    RENDER_PANEL,
+    RENDER_SLOT_COUNT
+} RenderSlot;
+
+/** Attach a text layer to a slot **/
+void render_add_text_layer(RenderSlot slot, TextLayer *layer);
+
+/** Attach a plain layer to a slot **/
+void render_add_layer(RenderSlot slot, Layer *layer);
+
+/** Forget every layer and drop pending work, before the layers are destroyed **/
+void render_remove_all(void);
+
+/** Queue new text for a text slot, applied only if it differs from what is shown **/
+void render_set_text(RenderSlot slot, const char *text);
+
+/** Queue a redraw of a slot **/
+void render_invalidate(RenderSlot slot);
+
+/** Apply everything queued so far right away **/
+void render_flush(void);
+
+/** Number of times a slot was actually redrawn **/
+uint32_t render_get_redraws(RenderSlot slot);
@@ -0,0 +1,88 @@
+#include <pebble.h>
+#include "settings.h"
+#include "weather.h"
+#include "power.h"
+#include "profile.h"
+#include "journal.h"
+
+#define KEY_SETTINGS 10
+#define SETTINGS_VERSION 3
+// Version 1 blobs end before the config version, version 2 ones before the power thresholds
+#define SETTINGS_V1_SIZE offsetof(Settings, config_version)
+#define SETTINGS_V2_SIZE offsetof(Settings, power_saver)
+
+// Keys each setting used to be persisted under
+#define LEGACY_KEY_TWENTY_FOUR_HOUR_FORMAT 1
+#define LEGACY_KEY_BATTERY_ON_OFF 2
+#define LEGACY_KEY_TEMP_TYPE 3
+#define LEGACY_KEY_INVERT_COLOR 5
+#define LEGACY_KEY_WEATHER_INTERVAL 7
+
+static const Settings s_defaults = {
+    .version = SETTINGS_VERSION,
+    .twenty_four_hour = false,
+    .battery_on = false,
+    .temp_format = TEMP_FAHRENHEIT,
+    .inverted = false,
+    .weather_interval = WEATHER_DEFAULT_FRESHNESS,
+    .config_version = 0,
+    .power_saver = POWER_SAVER_DEFAULT,
+    .power_critical = POWER_CRITICAL_DEFAULT,
+};
+
+/** Pull the old per-setting keys into the blob and drop them **/
+static void migrate(Settings *settings){
+    if(persist_exists(LEGACY_KEY_TWENTY_FOUR_HOUR_FORMAT))
+        settings->twenty_four_hour = persist_read_bool(LEGACY_KEY_TWENTY_FOUR_HOUR_FORMAT);
+    if(persist_exists(LEGACY_KEY_BATTERY_ON_OFF))
+        settings->battery_on = persist_read_bool(LEGACY_KEY_BATTERY_ON_OFF);
+    if(persist_exists(LEGACY_KEY_TEMP_TYPE)){
+        char name[sizeof("Fahrenheit")];
+        persist_read_string(LEGACY_KEY_TEMP_TYPE, name, sizeof(name));
+        settings->temp_format = settings_parse_temp_format(name);
+    }
+    if(persist_exists(LEGACY_KEY_INVERT_COLOR))
+        settings->inverted = persist_read_bool(LEGACY_KEY_INVERT_COLOR);
+    if(persist_exists(LEGACY_KEY_WEATHER_INTERVAL))
+        settings->weather_interval = persist_read_int(LEGACY_KEY_WEATHER_INTERVAL);
+
+    settings_save(settings);
+
+    persist_delete(LEGACY_KEY_TWENTY_FOUR_HOUR_FORMAT);
+    persist_delete(LEGACY_KEY_BATTERY_ON_OFF);
+    persist_delete(LEGACY_KEY_TEMP_TYPE);
+    persist_delete(LEGACY_KEY_INVERT_COLOR);
+    persist_delete(LEGACY_KEY_WEATHER_INTERVAL);
+    APP_LOG(APP_LOG_LEVEL_INFO, "Migrated settings to version %d", SETTINGS_VERSION);
+}
+
+void settings_load(Settings *settings){
+    PROFILE_COUNT(PROFILE_PERSIST_READS, 1);
+    *settings = s_defaults;
+    int size = persist_read_data(KEY_SETTINGS, settings, sizeof(*settings));
+    if(size == sizeof(*settings) && settings->version == SETTINGS_VERSION)
+        return;
+
+    // Older versions only lack the fields added since, those keep their defaults
+    if((size == (int)SETTINGS_V1_SIZE && settings->version == 1) ||
+       (size == (int)SETTINGS_V2_SIZE && settings->version == 2)){
+        settings->version = SETTINGS_VERSION;
+        settings_save(settings);
+        return;
+    }
+
+    *settings = s_defaults;
+    migrate(settings);
+}
+
+void settings_save(const Settings *settings){
+    journal_mark(KEY_SETTINGS, settings, sizeof(*settings));
+}
+
+TempFormat settings_parse_temp_format(const char *name){
+    switch(name != NULL ? name[0] : 'F'){
+        case 'C': return TEMP_CELSIUS;
+        case 'K': return TEMP_KELVIN;
+        default: return TEMP_FAHRENHEIT;
+    }
+}
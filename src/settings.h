@@ -0,0 +1,32 @@
+#pragma once
+
+#include <pebble.h>
+
+typedef enum {
+    TEMP_FAHRENHEIT,
+    TEMP_CELSIUS,
+    TEMP_KELVIN
+} TempFormat;
+
+/** Every user setting, persisted as one versioned blob **/
+typedef struct {
+    uint8_t version;
+    bool twenty_four_hour;
+    bool battery_on;
+    uint8_t temp_format;
+    bool inverted;
+    uint8_t reserved;
+    uint16_t weather_interval;
+    uint16_t config_version;    // last config sync the phone sent, 0 before the first
+    uint8_t power_saver;        // battery percentages the power tiers start at, see power.h
+    uint8_t power_critical;
+} Settings;
+
+/** Read the settings in one call, migrating the old per-setting keys once **/
+void settings_load(Settings *settings);
+
+/** Stage the settings blob for the next journal_flush(), settings has to stay put until then **/
+void settings_save(const Settings *settings);
+
+/** Temperature format from its config page name ("Fahrenheit", "Celcius", "Kelvin") **/
+TempFormat settings_parse_temp_format(const char *name);
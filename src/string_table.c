@@ -0,0 +1,123 @@
+#include <pebble.h>
+#include "string_table.h"
+
+/**
+ * Tables are generated by tools/strings.py:
+ * [version][strings before the quotes][quote count uint16]
+ * then an offset (uint16) for every string plus one past the last, and the
+ * string bytes without terminators. Integers are little endian.
+ **/
+#define STRINGS_VERSION 1
+#define STRINGS_HEADER 4
+#define STRINGS_FIXED (STRING_FIXED_COUNT + 2 * BANNER_COUNT)
+
+typedef struct {
+    const char *language;
+    uint32_t resource_id;
+} StringTable;
+
+// The first table is the fallback
+static const StringTable s_tables[] = {
+    { "en", RESOURCE_ID_STRINGS_EN },
+    { "es", RESOURCE_ID_STRINGS_ES },
+    { "fr", RESOURCE_ID_STRINGS_FR },
+    { "de", RESOURCE_ID_STRINGS_DE },
+};
+
+static ResHandle s_handle;
+static uint16_t s_count;
+static uint16_t s_thoughts;
+
+static uint16_t read_u16(const uint8_t *bytes){
+    return bytes[0] | (bytes[1] << 8);
+}
+
+void string_table_init(void){
+    const char *locale = i18n_get_system_locale();
+    const StringTable *table = &s_tables[0];
+    for(unsigned int i = 0; i < ARRAY_LENGTH(s_tables); i++){
+        if(strncmp(locale, s_tables[i].language, 2) == 0)
+            table = &s_tables[i];
+    }
+
+    // Only the header stays in RAM, strings are read when they are shown
+    uint8_t header[STRINGS_HEADER];
+    s_handle = resource_get_handle(table->resource_id);
+    if(resource_load_byte_range(s_handle, 0, header, sizeof(header)) != sizeof(header) ||
+       header[0] != STRINGS_VERSION || header[1] != STRINGS_FIXED){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "String table %s doesn't match the face", table->language);
+        s_handle = NULL;
+        s_count = 0;
+        s_thoughts = 0;
+        return;
+    }
+    s_thoughts = read_u16(header + 2);
+    s_count = STRINGS_FIXED + s_thoughts;
+}
+
+const char *string_table_get(uint16_t id, char *buffer, size_t size){
+    buffer[0] = '\0';
+    if(s_handle == NULL || id >= s_count)
+        return buffer;
+
+    uint8_t range[4];
+    if(resource_load_byte_range(s_handle, STRINGS_HEADER + id * 2, range, sizeof(range)) != sizeof(range))
+        return buffer;
+    size_t start = read_u16(range);
+    size_t length = read_u16(range + 2) - start;
+    if(length >= size)
+        length = size - 1;
+
+    size_t data = STRINGS_HEADER + (s_count + 1) * 2;
+    if(resource_load_byte_range(s_handle, data + start, (uint8_t *)buffer, length) != length)
+        length = 0;
+    buffer[length] = '\0';
+    return buffer;
+}
+
+/** Next conversion in a format and its length, 0 for one the face doesn't write; NULL past the last **/
+static const char *next_conversion(const char *format, size_t *length){
+    const char *start = strchr(format, '%');
+    if(start == NULL)
+        return NULL;
+    const char *end = start + 1;
+    end += strspn(end, "-+ 0#");
+    end += strspn(end, "0123456789");
+    if(*end == '.'){
+        end++;
+        end += strspn(end, "0123456789");
+    }
+    end += strspn(end, "hlLjzt");
+    *length = *end != '\0' && strchr("diouxXcsfFeEgG%", *end) != NULL ? (size_t)(end + 1 - start) : 0;
+    return start;
+}
+
+/** Whether two formats take the same arguments, conversion for conversion **/
+static bool same_conversions(const char *format, const char *fallback){
+    size_t length, fallback_length;
+    for(;;){
+        format = next_conversion(format, &length);
+        fallback = next_conversion(fallback, &fallback_length);
+        if(format == NULL || fallback == NULL)
+            return format == fallback;
+        if(length == 0 || length != fallback_length || strncmp(format, fallback, length) != 0)
+            return false;
+        format += length;
+        fallback += length;
+    }
+}
+
+const char *string_table_get_format(uint16_t id, const char *fallback, char *buffer, size_t size){
+    string_table_get(id, buffer, size);
+    if(buffer[0] == '\0')
+        return fallback;
+    if(!same_conversions(buffer, fallback)){
+        APP_LOG(APP_LOG_LEVEL_WARNING, "String %d doesn't take the arguments of \"%s\"", id, fallback);
+        return fallback;
+    }
+    return buffer;
+}
+
+uint16_t string_table_thought_count(void){
+    return s_thoughts;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <pebble.h>
+#include "holidays.h"
+
+// Buffer a string from the table fits in, tools/strings.py rejects longer ones
+#define STRING_SIZE 48
+
+/**
+ * Strings that don't belong to a banner. tools/strings.py reads the names
+ * below to lay out the tables, so they match the keys in resources/strings.
+ **/
+typedef enum {
+    STRING_BIRTHDAY_GREETING,   // "%s's Birthday!"
+    STRING_COUNTDOWN_HOLIDAY,   // "%s in %d %s"
+    STRING_COUNTDOWN_BIRTHDAY,  // "%d %s to %s's birthday"
+    STRING_DAY,
+    STRING_DAYS,
+    STRING_FIXED_COUNT
+} StringId;
+
+// Then the banners, the holiday names for countdowns and the quotes
+#define STRING_BANNER(banner) (STRING_FIXED_COUNT + (banner))
+#define STRING_EVENT(banner) (STRING_FIXED_COUNT + BANNER_COUNT + (banner))
+#define STRING_THOUGHT(index) (STRING_FIXED_COUNT + 2 * BANNER_COUNT + (index))
+
+/** Pick the table for the watch's language, English without one **/
+void string_table_init(void);
+
+/** Read one string into a buffer, empty if the table doesn't have it **/
+const char *string_table_get(uint16_t id, char *buffer, size_t size);
+
+/**
+ * A table string to format with, when its conversions are exactly the ones
+ * of the fallback, the English format the caller passes its arguments for.
+ * Otherwise, or without the string, the fallback.
+ **/
+const char *string_table_get_format(uint16_t id, const char *fallback, char *buffer, size_t size);
+
+/** Number of Thursday quotes in the table **/
+uint16_t string_table_thought_count(void);
@@ -0,0 +1,82 @@
+#include <pebble.h>
+#include <stdarg.h>
+#include "text.h"
+
+/** All the text lives here, sized at compile time **/
+typedef struct {
+    char time[TEXT_TIME_SIZE];
+    char date[TEXT_DATE_SIZE];
+    char banner[TEXT_BANNER_SIZE];
+    char temperature[TEXT_TEMPERATURE_SIZE];
+    char countdown[TEXT_COUNTDOWN_SIZE];
+} TextArena;
+
+static TextArena s_arena;
+
+typedef struct {
+    uint16_t offset;
+    uint16_t size;
+} TextRegion;
+
+static const TextRegion s_regions[TEXT_SLOT_COUNT] = {
+    [TEXT_TIME]        = { offsetof(TextArena, time), TEXT_TIME_SIZE },
+    [TEXT_DATE]        = { offsetof(TextArena, date), TEXT_DATE_SIZE },
+    [TEXT_BANNER]      = { offsetof(TextArena, banner), TEXT_BANNER_SIZE },
+    [TEXT_TEMPERATURE] = { offsetof(TextArena, temperature), TEXT_TEMPERATURE_SIZE },
+    [TEXT_COUNTDOWN]   = { offsetof(TextArena, countdown), TEXT_COUNTDOWN_SIZE },
+};
+
+char *text_buffer(TextSlot slot){
+    return (char *)&s_arena + s_regions[slot].offset;
+}
+
+size_t text_size(TextSlot slot){
+    return s_regions[slot].size;
+}
+
+/** Drop the last character of a string if some of its bytes were cut off **/
+static void drop_partial_character(char *text, size_t length){
+    size_t start = length;
+    while(start > 0 && ((uint8_t)text[start - 1] & 0xC0) == 0x80)
+        start--;
+    if(start == 0)
+        return;
+
+    // start - 1 is the lead byte, it tells how long the character should be
+    uint8_t lead = (uint8_t)text[start - 1];
+    size_t needed = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    if(length - (start - 1) < needed)
+        text[start - 1] = '\0';
+}
+
+const char *text_finish(TextSlot slot, int length){
+    char *buffer = text_buffer(slot);
+    size_t size = s_regions[slot].size;
+
+    // snprintf cuts at a byte, which may be in the middle of a character
+    if(length < 0)
+        buffer[0] = '\0';
+    else if((size_t)length >= size)
+        drop_partial_character(buffer, size - 1);
+    return buffer;
+}
+
+const char *text_format_string(TextSlot slot, uint16_t id, const char *literal, ...){
+    char format[STRING_SIZE];
+    va_list args;
+    va_start(args, literal);
+    int length = vsnprintf(text_buffer(slot), text_size(slot), string_table_get_format(id, literal, format, sizeof(format)), args);
+    va_end(args);
+    return text_finish(slot, length);
+}
+
+const char *text_strftime(TextSlot slot, const char *format, const struct tm *time){
+    char *buffer = text_buffer(slot);
+    if(strftime(buffer, s_regions[slot].size, format, time) == 0)
+        buffer[0] = '\0';
+    return buffer;
+}
+
+const char *text_get(TextSlot slot){
+    return text_buffer(slot);
+}
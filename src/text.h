@@ -0,0 +1,46 @@
+#pragma once
+
+#include <pebble.h>
+#include "birthdays.h"
+#include "string_table.h"
+
+// Sizes include the terminator, banners are a table string with at most a name in them
+#define TEXT_TIME_SIZE 8
+#define TEXT_DATE_SIZE 24
+#define TEXT_BANNER_SIZE (STRING_SIZE + BIRTHDAY_NAME_MAX)
+#define TEXT_TEMPERATURE_SIZE 12
+#define TEXT_COUNTDOWN_SIZE (STRING_SIZE + BIRTHDAY_NAME_MAX)
+
+/** Every piece of text the face builds at runtime has its own slot **/
+typedef enum {
+    TEXT_TIME,
+    TEXT_DATE,
+    TEXT_BANNER,
+    TEXT_TEMPERATURE,
+    TEXT_COUNTDOWN,
+    TEXT_SLOT_COUNT
+} TextSlot;
+
+/** Buffer of a slot and its size, for writing into it directly **/
+char *text_buffer(TextSlot slot);
+size_t text_size(TextSlot slot);
+
+/** Finish a slot snprintf wrote length bytes into, dropping a character cut in half **/
+const char *text_finish(TextSlot slot, int length);
+
+/** printf into a slot, cut at a UTF-8 character boundary when it doesn't fit **/
+#define TEXT_FORMAT(slot, ...) text_finish((slot), snprintf(text_buffer(slot), text_size(slot), __VA_ARGS__))
+
+/**
+ * printf a format from the string table into a slot. The literal is the
+ * English format: the compiler checks the arguments against it, and a table
+ * string that takes other arguments is passed over for it.
+ **/
+const char *text_format_string(TextSlot slot, uint16_t id, const char *literal, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/** strftime into a slot **/
+const char *text_strftime(TextSlot slot, const char *format, const struct tm *time);
+
+/** Current text of a slot **/
+const char *text_get(TextSlot slot);
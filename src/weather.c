@@ -0,0 +1,265 @@
+#include <pebble.h>
+#include "weather.h"
+#include "profile.h"
+#include "journal.h"
+
+// A request without a reply after this long counts as failed
+#define WEATHER_REQUEST_TIMEOUT (2 * SECONDS_PER_MINUTE)
+#define WEATHER_BACKOFF_MIN SECONDS_PER_MINUTE
+#define WEATHER_BACKOFF_MAX SECONDS_PER_HOUR
+
+// The face used to ask on every half hour
+#define WEATHER_LEGACY_PERIOD 30
+
+// Forecast samples are three hours apart, refresh before the last one runs out
+#define WEATHER_FORECAST_STEP (3 * SECONDS_PER_HOUR)
+#define WEATHER_FORECAST_MARGIN SECONDS_PER_HOUR
+#define WEATHER_FORECAST_VERSION 1
+#define WEATHER_FORECAST_HEADER 2
+#define WEATHER_FORECAST_RECORD 6
+
+// Persist keys 60-69 belong to the weather
+#define KEY_WEATHER_SNAPSHOT 60
+#define KEY_FORECAST_SNAPSHOT 61
+
+/** Last temperature, kept so launches show it right away **/
+typedef struct {
+    int32_t temperature;
+    uint32_t time;
+} WeatherSnapshot;
+
+typedef struct {
+    uint32_t time;
+    int16_t temperature;
+} ForecastSample;
+
+/** Ring buffer of upcoming samples, oldest at head **/
+typedef struct {
+    uint8_t head;
+    uint8_t count;
+    ForecastSample samples[WEATHER_FORECAST_SLOTS];
+} Forecast;
+
+static bool s_connected;
+static bool s_in_flight;
+static time_t s_sent_at;
+static time_t s_last_update;
+static int32_t s_temperature;
+static time_t s_retry_at;
+static uint32_t s_backoff;
+static uint16_t s_freshness = WEATHER_DEFAULT_FRESHNESS;
+static WeatherStats s_stats;
+static Forecast s_forecast;
+static WeatherSnapshot s_snapshot;
+
+static ForecastSample *forecast_at(int index){
+    return &s_forecast.samples[(s_forecast.head + index) % WEATHER_FORECAST_SLOTS];
+}
+
+static void forecast_push(ForecastSample sample){
+    if(s_forecast.count == WEATHER_FORECAST_SLOTS){
+        s_forecast.head = (s_forecast.head + 1) % WEATHER_FORECAST_SLOTS;
+        s_forecast.count--;
+    }
+    *forecast_at(s_forecast.count) = sample;
+    s_forecast.count++;
+}
+
+/** Sample whose slot covers a time, NULL if the forecast doesn't reach it **/
+static const ForecastSample *forecast_find(time_t when){
+    for(int i = s_forecast.count - 1; i >= 0; i--){
+        const ForecastSample *sample = forecast_at(i);
+        if((time_t)sample->time <= when)
+            return when < (time_t)sample->time + WEATHER_FORECAST_STEP ? sample : NULL;
+    }
+    return NULL;
+}
+
+/** Whether the observed temperature is older than the freshness window **/
+static bool observation_stale(time_t now){
+    return s_last_update == 0 || now - s_last_update >= (time_t)s_freshness * SECONDS_PER_MINUTE;
+}
+
+/** Whether neither the observation nor the forecast will cover the next while **/
+static bool is_stale(time_t now){
+    return observation_stale(now) && forecast_find(now + WEATHER_FORECAST_MARGIN) == NULL;
+}
+
+static void backoff(time_t now){
+    s_in_flight = false;
+    s_stats.failures++;
+    s_backoff = s_backoff == 0 ? WEATHER_BACKOFF_MIN : s_backoff * 2;
+    if(s_backoff > WEATHER_BACKOFF_MAX)
+        s_backoff = WEATHER_BACKOFF_MAX;
+    s_retry_at = now + s_backoff;
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Weather request failed, retry in %d s", (int)s_backoff);
+}
+
+static void send_request(time_t now){
+    DictionaryIterator *iter;
+    if(app_message_outbox_begin(&iter) != APP_MSG_OK){
+        backoff(now);
+        return;
+    }
+
+    dict_write_uint8(iter, KEY_TEMPERATURE, 0);
+    PROFILE_TRACE_REQUEST(iter);
+    if(app_message_outbox_send() != APP_MSG_OK){
+        backoff(now);
+        return;
+    }
+
+    s_stats.requests++;
+    if(s_backoff != 0)
+        s_stats.retries++;
+    s_in_flight = true;
+    s_sent_at = now;
+}
+
+void weather_init(bool connected){
+    s_connected = connected;
+
+    PROFILE_COUNT(PROFILE_PERSIST_READS, 2);
+    if(persist_read_data(KEY_WEATHER_SNAPSHOT, &s_snapshot, sizeof(s_snapshot)) == sizeof(s_snapshot)){
+        s_temperature = s_snapshot.temperature;
+        s_last_update = s_snapshot.time;
+    }
+
+    if(persist_read_data(KEY_FORECAST_SNAPSHOT, &s_forecast, sizeof(s_forecast)) != sizeof(s_forecast) ||
+       s_forecast.count > WEATHER_FORECAST_SLOTS || s_forecast.head >= WEATHER_FORECAST_SLOTS)
+        s_forecast = (Forecast){ 0 };
+}
+
+void weather_set_freshness(uint16_t minutes){
+    s_freshness = minutes > 0 ? minutes : WEATHER_DEFAULT_FRESHNESS;
+}
+
+void weather_tick(struct tm *tick_time){
+    time_t now = time(NULL);
+    bool legacy_wakeup = tick_time->tm_min % WEATHER_LEGACY_PERIOD == 0;
+
+    if(s_in_flight && now - s_sent_at >= WEATHER_REQUEST_TIMEOUT)
+        backoff(now);
+
+    if(!s_connected || s_in_flight || !is_stale(now) || now < s_retry_at){
+        if(legacy_wakeup)
+            s_stats.wakeups_saved++;
+        return;
+    }
+
+    send_request(now);
+}
+
+void weather_connection_changed(bool connected){
+    s_connected = connected;
+    if(!connected){
+        // Anything in flight is lost with the connection
+        s_in_flight = false;
+        return;
+    }
+
+    // One catch-up request, the link is fresh so skip any backoff
+    time_t now = time(NULL);
+    if(!s_in_flight && is_stale(now)){
+        s_backoff = 0;
+        s_retry_at = 0;
+        send_request(now);
+    }
+}
+
+void weather_received(int32_t temperature, time_t observed){
+    time_t now = time(NULL);
+    if(observed <= 0 || observed > now)
+        observed = now;
+
+    s_temperature = temperature;
+    s_last_update = observed;
+    s_in_flight = false;
+    s_backoff = 0;
+    s_retry_at = 0;
+
+    // A new reading of the same temperature only moves the time, weather_deinit() stores that
+    bool changed = s_snapshot.time == 0 || s_snapshot.temperature != temperature;
+    s_snapshot = (WeatherSnapshot){
+        .temperature = temperature,
+        .time = (uint32_t)observed,
+    };
+    if(changed)
+        journal_mark(KEY_WEATHER_SNAPSHOT, &s_snapshot, sizeof(s_snapshot));
+}
+
+static int32_t read_le(const uint8_t *bytes, int size){
+    uint32_t value = 0;
+    for(int i = size - 1; i >= 0; i--)
+        value = (value << 8) | bytes[i];
+    return (int32_t)value;
+}
+
+void weather_forecast_received(const uint8_t *data, size_t length){
+    if(length < WEATHER_FORECAST_HEADER || data[0] != WEATHER_FORECAST_VERSION ||
+       length < WEATHER_FORECAST_HEADER + (size_t)data[1] * WEATHER_FORECAST_RECORD){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Bad forecast block");
+        return;
+    }
+
+    int count = data[1];
+    if(count == 0)
+        return;
+    Forecast before = s_forecast;
+    const uint8_t *records = data + WEATHER_FORECAST_HEADER;
+    time_t first = (time_t)read_le(records, 4);
+
+    // New samples replace anything from their start on, old ones fall off the front
+    while(s_forecast.count > 0 && (time_t)forecast_at(s_forecast.count - 1)->time >= first)
+        s_forecast.count--;
+    time_t now = time(NULL);
+    while(s_forecast.count > 0 && (time_t)forecast_at(0)->time + WEATHER_FORECAST_STEP <= now){
+        s_forecast.head = (s_forecast.head + 1) % WEATHER_FORECAST_SLOTS;
+        s_forecast.count--;
+    }
+
+    for(int i = 0; i < count; i++){
+        const uint8_t *record = records + i * WEATHER_FORECAST_RECORD;
+        forecast_push((ForecastSample){
+            .time = (uint32_t)read_le(record, 4),
+            .temperature = (int16_t)read_le(record + 4, 2),
+        });
+    }
+
+    // The same samples sent again aren't worth a flash write
+    if(memcmp(&before, &s_forecast, sizeof(s_forecast)) != 0)
+        journal_mark(KEY_FORECAST_SNAPSHOT, &s_forecast, sizeof(s_forecast));
+}
+
+void weather_deinit(void){
+    if(s_snapshot.time != 0)
+        journal_mark(KEY_WEATHER_SNAPSHOT, &s_snapshot, sizeof(s_snapshot));
+}
+
+bool weather_has_temperature(void){
+    return s_last_update != 0 || s_forecast.count > 0;
+}
+
+int32_t weather_temperature(void){
+    time_t now = time(NULL);
+    if(!observation_stale(now))
+        return s_temperature;
+
+    // Between fetches the forecast slot for now stands in
+    const ForecastSample *sample = forecast_find(now);
+    return sample != NULL ? sample->temperature : s_temperature;
+}
+
+bool weather_is_stale(void){
+    time_t now = time(NULL);
+    return observation_stale(now) && forecast_find(now) == NULL;
+}
+
+void weather_outbox_failed(DictionaryIterator *iterator){
+    if(dict_find(iterator, KEY_TEMPERATURE) != NULL)
+        backoff(time(NULL));
+}
+
+void weather_get_stats(WeatherStats *stats){
+    *stats = s_stats;
+}
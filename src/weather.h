@@ -0,0 +1,62 @@
+#pragma once
+
+#include <pebble.h>
+
+// AppMessage key of the weather request and the temperature reply
+#define KEY_TEMPERATURE 0
+// Unix time the phone observed the temperature at
+#define KEY_WEATHER_TIME 8
+// Block of upcoming temperature samples
+#define KEY_WEATHER_FORECAST 9
+
+#define WEATHER_DEFAULT_FRESHNESS 30
+#define WEATHER_FORECAST_SLOTS 8
+// A full forecast block, 2 header bytes then 6 bytes per sample
+#define WEATHER_FORECAST_MESSAGE_MAX (2 + WEATHER_FORECAST_SLOTS * 6)
+
+/** Counters for the weather refresh scheduler **/
+typedef struct {
+    uint32_t requests;
+    uint32_t retries;
+    uint32_t failures;
+    uint32_t wakeups_saved;
+} WeatherStats;
+
+/** Start scheduling with the Bluetooth state at launch, restoring the last snapshot **/
+void weather_init(bool connected);
+
+/** Stage the last reading for the journal, its time included, ahead of the final flush **/
+void weather_deinit(void);
+
+/** How old, in minutes, the temperature may get before it is refreshed **/
+void weather_set_freshness(uint16_t minutes);
+
+/** Minute tick, sends a request when the temperature is due for a refresh **/
+void weather_tick(struct tm *tick_time);
+
+/** Bluetooth connection changes, a reconnect catches up once if stale **/
+void weather_connection_changed(bool connected);
+
+/** A temperature (Fahrenheit) arrived from the phone, observed at a unix time or 0 for now **/
+void weather_received(int32_t temperature, time_t observed);
+
+/**
+ * A forecast block arrived from the phone:
+ * [version][count] then count x [uint32 unix time][int16 Fahrenheit], little endian.
+ **/
+void weather_forecast_received(const uint8_t *data, size_t length);
+
+/** Whether any temperature is known, from the phone or the snapshot **/
+bool weather_has_temperature(void);
+
+/** Current temperature in Fahrenheit, from the last reading or the forecast **/
+int32_t weather_temperature(void);
+
+/** Whether neither a fresh reading nor the forecast covers the current time **/
+bool weather_is_stale(void);
+
+/** An outbox message failed, backs off if it was a weather request **/
+void weather_outbox_failed(DictionaryIterator *iterator);
+
+/** Copy out the scheduler counters **/
+void weather_get_stats(WeatherStats *stats);
@@ -0,0 +1,340 @@
+#!/usr/bin/env python
+#
+# Prepares the image resources before the Pebble SDK packs them.
+#
+# Every background ("bitmap" resource) is scaled to fit the 144x88
+# background layer and written next to its source as two variants the SDK
+# picks per platform:
+#   name~bw.png     1-bit, for aplite
+#   name~color.png  at most 16 colors from the Pebble palette, for basalt
+# A background that comes out pixel-identical to an earlier one fails the
+# build with the pair reported, its appinfo.json entry has to point at the
+# earlier file by hand. A per-resource size report is checked against a
+# byte budget on each platform.
+#
+# Plain python (2 or 3) with zlib only, the SDK environment has no imaging
+# library to rely on.
+#
+
+import json
+import os
+import struct
+import sys
+import zlib
+
+FRAME_WIDTH = 144
+FRAME_HEIGHT = 88
+COLOR_LIMIT = 16
+# Total bytes the decoded bitmaps of one platform may take
+DEFAULT_BUDGET = 64 * 1024
+# Header in front of the pixels of a decoded GBitmap
+BITMAP_HEADER = 12
+
+VARIANTS = ('~bw', '~color')
+
+
+class AssetError(Exception):
+    pass
+
+
+class Image(object):
+    """RGBA pixels, one (r, g, b, a) tuple per pixel, rows top to bottom."""
+
+    def __init__(self, width, height, pixels):
+        self.width = width
+        self.height = height
+        self.pixels = pixels
+
+
+def read_chunks(data):
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise AssetError('not a PNG')
+    pos = 8
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        yield kind, data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+
+
+def unfilter(raw, width, height, bpp, row_bytes):
+    rows = []
+    prev = bytearray(row_bytes)
+    pos = 0
+    for _ in range(height):
+        kind = raw[pos]
+        row = bytearray(raw[pos + 1:pos + 1 + row_bytes])
+        pos += 1 + row_bytes
+        for i in range(row_bytes):
+            left = row[i - bpp] if i >= bpp else 0
+            up = prev[i]
+            if kind == 1:
+                row[i] = (row[i] + left) & 0xff
+            elif kind == 2:
+                row[i] = (row[i] + up) & 0xff
+            elif kind == 3:
+                row[i] = (row[i] + ((left + up) >> 1)) & 0xff
+            elif kind == 4:
+                corner = prev[i - bpp] if i >= bpp else 0
+                p = left + up - corner
+                pa, pb, pc = abs(p - left), abs(p - up), abs(p - corner)
+                if pa <= pb and pa <= pc:
+                    row[i] = (row[i] + left) & 0xff
+                elif pb <= pc:
+                    row[i] = (row[i] + up) & 0xff
+                else:
+                    row[i] = (row[i] + corner) & 0xff
+            elif kind != 0:
+                raise AssetError('bad filter %d' % kind)
+        rows.append(row)
+        prev = row
+    return rows
+
+
+def samples(row, count, depth):
+    """Unpack a row into count samples of the given bit depth, scaled to 8 bits."""
+    if depth == 8:
+        return list(row[:count])
+    if depth == 16:
+        return list(row[0:count * 2:2])
+    per_byte = 8 // depth
+    mask = (1 << depth) - 1
+    values = []
+    for i in range(count):
+        byte = row[i // per_byte]
+        shift = 8 - depth * (i % per_byte + 1)
+        values.append((byte >> shift) & mask)
+    return values
+
+
+def decode_png(data):
+    data = bytearray(data)
+    header = None
+    palette = []
+    alpha = []
+    idat = bytearray()
+    for kind, body in read_chunks(bytes(data)):
+        if kind == b'IHDR':
+            header = struct.unpack('>IIBBBBB', body)
+        elif kind == b'PLTE':
+            body = bytearray(body)
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b'tRNS':
+            alpha = list(bytearray(body))
+        elif kind == b'IDAT':
+            idat += body
+
+    width, height, depth, color_type, _, _, interlace = header
+    if interlace:
+        raise AssetError('interlaced PNGs are not supported')
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    bits = channels * depth
+    bpp = max(1, bits // 8)
+    row_bytes = (width * bits + 7) // 8
+    rows = unfilter(bytearray(zlib.decompress(bytes(idat))), width, height, bpp, row_bytes)
+
+    pixels = []
+    scale = 255 // ((1 << depth) - 1) if depth < 8 else 1
+    for row in rows:
+        values = samples(row, width * channels, depth)
+        for x in range(width):
+            v = values[x * channels:(x + 1) * channels]
+            if color_type == 3:
+                r, g, b = palette[v[0]]
+                pixels.append((r, g, b, alpha[v[0]] if v[0] < len(alpha) else 255))
+            elif color_type == 0:
+                pixels.append((v[0] * scale,) * 3 + (255,))
+            elif color_type == 4:
+                pixels.append((v[0], v[0], v[0], v[1]))
+            elif color_type == 2:
+                pixels.append((v[0], v[1], v[2], 255))
+            else:
+                pixels.append(tuple(v))
+    return Image(width, height, pixels)
+
+
+def encode_png(width, height, depth, color_type, rows, palette=None, alpha=None):
+    def chunk(kind, body):
+        return (struct.pack('>I', len(body)) + kind + body +
+                struct.pack('>I', zlib.crc32(kind + body) & 0xffffffff))
+
+    raw = bytearray()
+    for row in rows:
+        raw.append(0)
+        raw += row
+    out = b'\x89PNG\r\n\x1a\n'
+    out += chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, depth, color_type, 0, 0, 0))
+    if palette:
+        out += chunk(b'PLTE', bytes(bytearray(c for rgb in palette for c in rgb)))
+    if alpha and any(a != 255 for a in alpha):
+        out += chunk(b'tRNS', bytes(bytearray(alpha)))
+    out += chunk(b'IDAT', zlib.compress(bytes(raw), 9))
+    out += chunk(b'IEND', b'')
+    return out
+
+
+def pack_row(values, depth):
+    per_byte = 8 // depth
+    row = bytearray((len(values) + per_byte - 1) // per_byte)
+    for i, v in enumerate(values):
+        row[i // per_byte] |= v << (8 - depth * (i % per_byte + 1))
+    return row
+
+
+def fit(image):
+    """Box-filter the image down to fit the background frame, never up."""
+    scale = max(float(image.width) / FRAME_WIDTH, float(image.height) / FRAME_HEIGHT)
+    if scale <= 1:
+        return image
+    width = max(1, int(image.width / scale))
+    height = max(1, int(image.height / scale))
+    pixels = []
+    for y in range(height):
+        y0, y1 = int(y * scale), max(int(y * scale) + 1, int((y + 1) * scale))
+        for x in range(width):
+            x0, x1 = int(x * scale), max(int(x * scale) + 1, int((x + 1) * scale))
+            total = [0, 0, 0, 0]
+            for sy in range(y0, min(y1, image.height)):
+                for sx in range(x0, min(x1, image.width)):
+                    p = image.pixels[sy * image.width + sx]
+                    for c in range(4):
+                        total[c] += p[c]
+            count = (min(y1, image.height) - y0) * (min(x1, image.width) - x0)
+            pixels.append(tuple(t // count for t in total))
+    return Image(width, height, pixels)
+
+
+def luminance(pixel):
+    r, g, b, a = pixel
+    if a < 128:
+        return 255
+    return (299 * r + 587 * g + 114 * b) // 1000
+
+
+def to_bw(image):
+    bits = [1 if luminance(p) >= 128 else 0 for p in image.pixels]
+    rows = [pack_row(bits[y * image.width:(y + 1) * image.width], 1) for y in range(image.height)]
+    return bits, encode_png(image.width, image.height, 1, 0, rows)
+
+
+def pebble_color(pixel):
+    """Nearest color of the 64 color Pebble palette, clear when mostly transparent."""
+    r, g, b, a = pixel
+    if a < 128:
+        return None
+    return tuple(((c + 42) // 85) * 85 for c in (r, g, b))
+
+
+def to_color(image):
+    colors = [pebble_color(p) for p in image.pixels]
+    counts = {}
+    for c in colors:
+        counts[c] = counts.get(c, 0) + 1
+    keep = sorted(counts, key=lambda c: (-counts[c], c is None, c))[:COLOR_LIMIT]
+
+    def nearest(c):
+        if c in keep or c is None:
+            return c
+        opaque = [k for k in keep if k is not None]
+        return min(opaque, key=lambda k: sum((k[i] - c[i]) ** 2 for i in range(3)))
+
+    palette = [k if k is not None else (255, 255, 255) for k in keep]
+    alpha = [0 if k is None else 255 for k in keep]
+    index = dict((k, i) for i, k in enumerate(keep))
+    values = [index[nearest(c)] for c in colors]
+    depth = 1
+    while (1 << depth) < len(palette):
+        depth *= 2
+    rows = [pack_row(values[y * image.width:(y + 1) * image.width], depth) for y in range(image.height)]
+    return depth, encode_png(image.width, image.height, depth, 3, rows, palette, alpha)
+
+
+def bitmap_bytes(width, height):
+    """Heap a 1-bit GBitmap of this size takes on aplite, rows are padded to 4 bytes."""
+    return BITMAP_HEADER + ((width + 31) // 32) * 4 * height
+
+
+def palette_bitmap_bytes(width, height, depth):
+    """Heap a palettized GBitmap takes on basalt, byte aligned rows then one byte per color."""
+    return BITMAP_HEADER + (width * depth + 7) // 8 * height + (1 << depth)
+
+
+def variant_path(path, suffix):
+    base, ext = os.path.splitext(path)
+    return base + suffix + ext
+
+
+def backgrounds(appinfo):
+    """Image resources drawn in the background layer, icons are left alone."""
+    for media in appinfo['resources']['media']:
+        if media['type'] == 'bitmap' and not media.get('menuIcon'):
+            yield media
+
+
+def process(root, budget, out=sys.stdout):
+    with open(os.path.join(root, 'appinfo.json')) as f:
+        appinfo = json.load(f)
+
+    seen = {}
+    done = set()
+    errors = []
+    total_source = total_bw = total_color = total_bw_heap = total_color_heap = 0
+    out.write('%-22s %8s %8s %8s %8s %8s\n' % ('resource', 'source', 'bw', 'color', 'bw heap', 'col heap'))
+
+    for media in backgrounds(appinfo):
+        # Entries already sharing a file ship it once
+        if media['file'] in done:
+            continue
+        path = os.path.join(root, 'resources', media['file'])
+        with open(path, 'rb') as f:
+            source = f.read()
+        image = fit(decode_png(source))
+        bits, bw = to_bw(image)
+        depth, color = to_color(image)
+
+        key = (bw, color)
+        if key in seen:
+            # The build doesn't touch appinfo.json, the entry is fixed by hand
+            original = seen[key]
+            out.write('%-22s same as %s\n' % (media['name'], original['name']))
+            errors.append('%s (%s) is identical to %s, point its "file" in appinfo.json at %s' %
+                          (media['name'], media['file'], original['name'], original['file']))
+            continue
+        seen[key] = media
+        done.add(media['file'])
+
+        for suffix, data in zip(VARIANTS, (bw, color)):
+            target = variant_path(path, suffix)
+            if not os.path.exists(target) or open(target, 'rb').read() != data:
+                with open(target, 'wb') as f:
+                    f.write(data)
+
+        bw_heap = bitmap_bytes(image.width, image.height)
+        color_heap = palette_bitmap_bytes(image.width, image.height, depth)
+        total_source += len(source)
+        total_bw += len(bw)
+        total_color += len(color)
+        total_bw_heap += bw_heap
+        total_color_heap += color_heap
+        out.write('%-22s %8d %8d %8d %8d %8d\n' % (media['name'], len(source), len(bw), len(color),
+                                                    bw_heap, color_heap))
+
+    out.write('%-22s %8d %8d %8d %8d %8d\n' % ('total', total_source, total_bw, total_color,
+                                                total_bw_heap, total_color_heap))
+
+    for platform, heap in (('aplite', total_bw_heap), ('basalt', total_color_heap)):
+        if heap > budget:
+            errors.append('%s bitmaps take %d bytes, over the %d byte budget' % (platform, heap, budget))
+    return errors
+
+
+def main(argv):
+    root = argv[1] if len(argv) > 1 else '.'
+    budget = int(argv[2]) if len(argv) > 2 else DEFAULT_BUDGET
+    errors = process(root, budget)
+    for error in errors:
+        sys.stderr.write('assets: %s\n' % error)
+    return 1 if errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
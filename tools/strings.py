@@ -0,0 +1,144 @@
+#!/usr/bin/env python
+#
+# Packs the face's text into one string table resource per language.
+#
+# resources/strings/<language>.json holds the fixed strings, the banners,
+# the holiday names used in countdowns and the Thursday quotes. Each one is
+# written next to it as <language>.bin, laid out the way src/string_table.c
+# reads it:
+#   [version][strings before the quotes][quote count uint16]
+#   [offset uint16] for every string plus one past the last
+#   string bytes, UTF-8 without terminators
+# The order of the strings comes from the enums in src/string_table.h and
+# src/holidays.h, so the tables can't drift from the C code. Strings a
+# language leaves out fall back to English.
+#
+
+import io
+import json
+import os
+import re
+import struct
+import sys
+
+VERSION = 1
+FALLBACK = 'en'
+# printf conversions, a translation has to use the same ones in the same order
+CONVERSION = re.compile(r'%[-+ 0#]*[0-9]*(?:\.[0-9]+)?[a-zA-Z%]')
+
+
+class StringError(Exception):
+    pass
+
+
+def enum_names(path, prefix, end):
+    """Names of an enum's members in order, without the prefix, up to the end marker."""
+    with open(path) as f:
+        source = f.read()
+    names = []
+    for match in re.finditer(r'^\s*' + prefix + r'([A-Z0-9_]+)\b', source, re.M):
+        name = match.group(1)
+        if name == end:
+            return names
+        names.append(name)
+    raise StringError('%s has no %s%s' % (path, prefix, end))
+
+
+def define_value(path, name):
+    with open(path) as f:
+        match = re.search(r'#define\s+' + name + r'\s+(\d+)', f.read())
+    if match is None:
+        raise StringError('%s has no %s' % (path, name))
+    return int(match.group(1))
+
+
+def load_language(path):
+    with io.open(path, encoding='utf-8') as f:
+        return json.load(f)
+
+
+def layout(root):
+    """Section and key of every string before the quotes, in table order."""
+    src = os.path.join(root, 'src')
+    fixed = enum_names(os.path.join(src, 'string_table.h'), 'STRING_', 'FIXED_COUNT')
+    banners = enum_names(os.path.join(src, 'holidays.h'), 'BANNER_', 'COUNT')
+    return ([('strings', name) for name in fixed] +
+            [('banners', name) for name in banners] +
+            [('events', name) for name in banners])
+
+
+def build_table(language, english, keys, limit):
+    strings = []
+    errors = []
+    for section, key in keys:
+        text = language.get(section, {}).get(key)
+        default = english.get(section, {}).get(key, u'')
+        if text is None:
+            text = default
+        elif CONVERSION.findall(text) != CONVERSION.findall(default):
+            errors.append('%s %s has to use %s' % (section, key, ' '.join(CONVERSION.findall(default)) or 'no conversions'))
+        strings.append(text)
+
+    thoughts = language.get('thoughts') or english.get('thoughts', [])
+    strings += thoughts
+
+    encoded = [s.encode('utf-8') for s in strings]
+    for (section, key), data in zip(keys + [('thoughts', i) for i in range(len(thoughts))], encoded):
+        if len(data) >= limit:
+            errors.append('%s %s is %d bytes, the face reads at most %d' % (section, key, len(data), limit - 1))
+
+    offsets = [0]
+    for data in encoded:
+        offsets.append(offsets[-1] + len(data))
+    if offsets[-1] > 0xffff:
+        errors.append('table is %d bytes, offsets only reach 65535' % offsets[-1])
+        return None, errors
+
+    header = struct.pack('<BBH', VERSION, len(keys), len(thoughts))
+    index = struct.pack('<%dH' % len(offsets), *offsets)
+    return header + index + b''.join(encoded), errors
+
+
+def declared_tables(appinfo):
+    return set(media['file'] for media in appinfo['resources']['media'] if media['type'] == 'raw')
+
+
+def process(root, out=sys.stdout):
+    directory = os.path.join(root, 'resources', 'strings')
+    with open(os.path.join(root, 'appinfo.json')) as f:
+        declared = declared_tables(json.load(f))
+
+    keys = layout(root)
+    limit = define_value(os.path.join(root, 'src', 'string_table.h'), 'STRING_SIZE')
+    english = load_language(os.path.join(directory, FALLBACK + '.json'))
+
+    errors = []
+    for name in sorted(os.listdir(directory)):
+        base, ext = os.path.splitext(name)
+        if ext != '.json':
+            continue
+        table, problems = build_table(load_language(os.path.join(directory, name)), english, keys, limit)
+        errors += ['%s: %s' % (base, problem) for problem in problems]
+        if table is None:
+            continue
+        if 'strings/%s.bin' % base not in declared:
+            errors.append('%s: strings/%s.bin is not a resource in appinfo.json' % (base, base))
+
+        target = os.path.join(directory, base + '.bin')
+        if not os.path.exists(target) or open(target, 'rb').read() != table:
+            with open(target, 'wb') as f:
+                f.write(table)
+        out.write('%-6s %6d bytes\n' % (base, len(table)))
+    return errors
+
+
+def main(argv):
+    root = argv[1] if len(argv) > 1 else '.'
+    errors = process(root)
+    for error in errors:
+        sys.stderr.write('strings: %s\n' % error)
+    return 1 if errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
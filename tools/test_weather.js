@@ -0,0 +1,232 @@
+#!/usr/bin/env node
+//
+// Runs the phone side of the face against tools/weather_server.py and
+// checks the weather client's request counts: overlapping asks from the
+// watch share one fetch, a fresh snapshot answers without the network,
+// an unchanged temperature isn't pushed again and city mode never asks
+// for a position.
+//
+// The app's scripts run in a sandbox with Pebble, localStorage,
+// XMLHttpRequest and geolocation stand-ins that count what they're asked.
+//
+//   node tools/test_weather.js
+//
+
+var childProcess = require('child_process');
+var fs = require('fs');
+var http = require('http');
+var path = require('path');
+var vm = require('vm');
+
+var ROOT = path.join(__dirname, '..');
+var SCRIPTS = ['src/js/calendar.js', 'src/js/pebble-js-app.js'];
+// Long enough that asks made in a burst overlap the fetch
+var SERVER_DELAY = 200;
+var PORT = 20000 + Math.floor(Math.random() * 20000);
+
+var failures = 0;
+
+function expect(ok, what) {
+  if(!ok){
+    console.error('test_weather: ' + what);
+    failures++;
+  }
+}
+
+function getJson(url, callback) {
+  http.get(url, function(response) {
+    var body = '';
+    response.on('data', function(data) { body += data; });
+    response.on('end', function() { callback(JSON.parse(body)); });
+  });
+}
+
+/** The app's scripts in a sandbox, with counters on everything they reach outside **/
+function loadApp(baseUrl) {
+  var listeners = {};
+  var storage = {};
+  var app = {
+    sent: [],
+    positions: 0,
+    requests: 0,
+    pending: 0
+  };
+
+  function XMLHttpRequest() {}
+  XMLHttpRequest.prototype.open = function(type, url) {
+    this.url = url;
+  };
+  XMLHttpRequest.prototype.send = function() {
+    var xhr = this;
+    app.requests++;
+    app.pending++;
+    http.get(xhr.url, function(response) {
+      var body = '';
+      response.on('data', function(data) { body += data; });
+      response.on('end', function() {
+        app.pending--;
+        xhr.responseText = body;
+        xhr.onload();
+      });
+    }).on('error', function() {
+      app.pending--;
+      xhr.onerror();
+    });
+  };
+
+  var sandbox = {
+    console: { log: function() {} },
+    XMLHttpRequest: XMLHttpRequest,
+    localStorage: {
+      getItem: function(key) { return storage.hasOwnProperty(key) ? storage[key] : null; },
+      setItem: function(key, value) { storage[key] = String(value); },
+      removeItem: function(key) { delete storage[key]; }
+    },
+    navigator: {
+      geolocation: {
+        getCurrentPosition: function(success) {
+          app.positions++;
+          setTimeout(function() {
+            success({ coords: { latitude: 51.5, longitude: -0.1 } });
+          }, 10);
+        }
+      }
+    },
+    Pebble: {
+      addEventListener: function(name, listener) { listeners[name] = listener; },
+      sendAppMessage: function(message, success) {
+        app.sent.push(message);
+        if(success)
+          setTimeout(success, 0);
+      },
+      openURL: function() {}
+    },
+    Date: Date,
+    JSON: JSON,
+    Math: Math,
+    setTimeout: setTimeout
+  };
+  sandbox.localStorage.setItem('weatherBaseUrl', baseUrl);
+  vm.createContext(sandbox);
+  SCRIPTS.forEach(function(script) {
+    vm.runInContext(fs.readFileSync(path.join(ROOT, script), 'utf8'), sandbox, { filename: script });
+  });
+
+  app.emit = function(name, event) {
+    listeners[name](event || {});
+  };
+  app.weatherSends = function() {
+    return app.sent.filter(function(message) { return message.KEY_TEMPERATURE !== undefined; }).length;
+  };
+  // Wait until no fetch is in flight and the acks have run
+  app.settle = function(callback) {
+    var poll = function() {
+      if(app.pending > 0 || sandbox.weatherWaiters !== null)
+        setTimeout(poll, 10);
+      else
+        setTimeout(callback, 20);
+    };
+    setTimeout(poll, 10);
+  };
+  return app;
+}
+
+/** Steps run one after another, each gets the next **/
+function run(steps) {
+  var next = function() {
+    var step = steps.shift();
+    if(step)
+      step(next);
+  };
+  next();
+}
+
+function main() {
+  var server = childProcess.spawn('python3', [path.join(__dirname, 'weather_server.py'),
+    '--port', String(PORT), '--delay', String(SERVER_DELAY)], { stdio: ['ignore', 'ignore', 'pipe'] });
+  var base = 'http://127.0.0.1:' + PORT;
+  var app;
+  var before;
+
+  process.on('exit', function() {
+    server.kill();
+  });
+  var finish = function() {
+    console.log('test_weather: ' + failures + ' failures');
+    process.exit(failures > 0 ? 1 : 0);
+  };
+  server.on('exit', function(code) {
+    if(code !== null){
+      console.error('test_weather: weather_server.py exited with ' + code);
+      process.exit(1);
+    }
+  });
+  var stats = function(callback) {
+    getJson(base + '/stats', function(report) {
+      var requests = report.requests;
+      callback((requests.weather || 0) + (requests.forecast || 0));
+    });
+  };
+
+  run([
+    // Up once the server says so
+    function(next) {
+      server.stderr.on('data', function listening(data) {
+        if(String(data).indexOf('listening') >= 0){
+          server.stderr.removeListener('data', listening);
+          next();
+        }
+      });
+    },
+    // Launch, then the watch asks three times while the first fetch runs
+    function(next) {
+      app = loadApp(base);
+      app.emit('ready');
+      app.emit('appmessage', { payload: { KEY_TEMPERATURE: 0 } });
+      app.emit('appmessage', { payload: { KEY_TEMPERATURE: 0 } });
+      app.emit('appmessage', { payload: { KEY_TEMPERATURE: 0 } });
+      app.settle(next);
+    },
+    function(next) {
+      stats(function(served) {
+        expect(served === 2, 'a burst made ' + served + ' requests, not one weather and one forecast');
+        expect(app.positions === 1, 'a burst asked for the position ' + app.positions + ' times');
+        expect(app.weatherSends() === 1, 'a burst got ' + app.weatherSends() + ' replies, not one');
+        next();
+      });
+    },
+    // The snapshot is fresh, asking again only sends it
+    function(next) {
+      before = app.requests;
+      app.emit('appmessage', { payload: { KEY_TEMPERATURE: 0 } });
+      app.settle(next);
+    },
+    function(next) {
+      expect(app.requests === before, 'a fresh snapshot went to the network');
+      expect(app.weatherSends() === 2, 'a fresh snapshot wasn\'t sent to the watch that asked');
+      next();
+    },
+    // A forced fetch with the same temperature isn't pushed to a watch that didn't ask
+    function(next) {
+      app.emit('webviewclosed', { response: encodeURIComponent(JSON.stringify({ useLocation: true })) });
+      app.settle(next);
+    },
+    function(next) {
+      expect(app.requests === before + 2, 'a forced fetch made ' + (app.requests - before) + ' requests');
+      expect(app.weatherSends() === 2, 'an unchanged temperature was pushed again');
+      next();
+    },
+    // City mode queries by name
+    function(next) {
+      before = app.positions;
+      app.emit('webviewclosed', { response: encodeURIComponent(JSON.stringify({ location: 'Paris' })) });
+      app.settle(next);
+    },
+    function(next) {
+      expect(app.positions === before, 'city mode asked for the position');
+      finish();
+    }
+  ]);
+}
+
+main();
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+#
+# Stands in for OpenWeatherMap so the weather path can be timed and loaded
+# without the network.
+#
+# Serves the two calls src/js/pebble-js-app.js makes, /weather and
+# /forecast, with temperatures in Kelvin like the real service, after a
+# configurable delay. Point the phone at it by setting weatherBaseUrl in the
+# app's localStorage to http://<this machine>:<port>. /stats reports the
+# requests served so far. Requests are handled on their own threads, so a
+# burst is delayed in parallel the way a real server would be.
+#
+# Plain python (2 or 3), standard library only.
+#
+
+import argparse
+import json
+import random
+import sys
+import threading
+import time
+
+try:
+    from http.server import BaseHTTPRequestHandler, HTTPServer
+    from socketserver import ThreadingMixIn
+    from urllib.parse import parse_qs, urlparse
+except ImportError:
+    from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+    from SocketServer import ThreadingMixIn
+    from urlparse import parse_qs, urlparse
+
+DEFAULT_PORT = 8080
+# 20 C
+DEFAULT_KELVIN = 293.15
+# Forecast samples are three hours apart
+FORECAST_STEP = 3 * 60 * 60
+FORECAST_MAX = 40
+
+
+class Stats(object):
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = {}
+        self.failures = 0
+        self.delays = []
+
+    def record(self, path, delay, failed):
+        with self.lock:
+            self.requests[path] = self.requests.get(path, 0) + 1
+            self.delays.append(delay)
+            if failed:
+                self.failures += 1
+
+    def report(self):
+        with self.lock:
+            delays = sorted(self.delays)
+            return {
+                'requests': dict(self.requests),
+                'failures': self.failures,
+                'delayMs': {
+                    'p50': percentile(delays, 50),
+                    'p90': percentile(delays, 90),
+                    'p99': percentile(delays, 99),
+                },
+            }
+
+
+def percentile(values, p):
+    """Nearest rank, the same way the phone reports its traces."""
+    if not values:
+        return 0
+    return values[max(0, -(-len(values) * p // 100) - 1)]
+
+
+def current(kelvin, now):
+    return {
+        'dt': now,
+        'name': 'Mock',
+        'main': {'temp': kelvin},
+    }
+
+
+def forecast(kelvin, now, count):
+    start = now - now % FORECAST_STEP + FORECAST_STEP
+    return {
+        'cnt': count,
+        'list': [{'dt': start + i * FORECAST_STEP, 'main': {'temp': kelvin + i % 4 - 1.5}}
+                 for i in range(count)],
+    }
+
+
+class ThreadingServer(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+
+def make_handler(options, stats):
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            url = urlparse(self.path)
+            query = parse_qs(url.query)
+            path = url.path.rstrip('/').split('/')[-1]
+
+            if path == 'stats':
+                self.reply(200, stats.report())
+                return
+            if path not in ('weather', 'forecast'):
+                self.reply(404, {'cod': '404', 'message': 'not found'})
+                return
+
+            delay = max(0, options.delay + random.randint(-options.jitter, options.jitter))
+            time.sleep(delay / 1000.0)
+            failed = random.random() < options.fail
+            stats.record(path, delay, failed)
+            if failed:
+                self.reply(500, {'cod': '500', 'message': 'mock failure'})
+                return
+
+            now = int(time.time())
+            if path == 'weather':
+                self.reply(200, current(options.kelvin, now))
+            else:
+                count = int(query.get('cnt', ['8'])[0])
+                self.reply(200, forecast(options.kelvin, now, min(max(count, 1), FORECAST_MAX)))
+
+        def reply(self, status, body):
+            data = json.dumps(body).encode('utf-8')
+            self.send_response(status)
+            self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(data)))
+            self.end_headers()
+            self.wfile.write(data)
+
+        def log_message(self, format, *args):
+            sys.stderr.write('weather_server: %s %s\n' % (self.address_string(), format % args))
+
+    return Handler
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Mock OpenWeatherMap for the face.')
+    parser.add_argument('--port', type=int, default=DEFAULT_PORT)
+    parser.add_argument('--delay', type=int, default=0, help='milliseconds before each reply')
+    parser.add_argument('--jitter', type=int, default=0, help='milliseconds the delay varies by, either way')
+    parser.add_argument('--fail', type=float, default=0, help='share of requests answered with a 500')
+    parser.add_argument('--kelvin', type=float, default=DEFAULT_KELVIN, help='temperature to report')
+    options = parser.parse_args(argv[1:])
+
+    server = ThreadingServer(('', options.port), make_handler(options, Stats()))
+    sys.stderr.write('weather_server: listening on %d, delay %d +/- %d ms, failing %d%%\n' %
+                     (options.port, options.delay, options.jitter, int(options.fail * 100)))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))